@@ -0,0 +1,302 @@
+#include "cbor.h"
+#include "cborwriter.h"
+#include "childgroups.h"
+#include "nodevalue.h"
+
+#include <QStack>
+
+#include <limits>
+
+namespace {
+
+/**
+ * @brief unquoted
+ * @return the attribute value without the quotes around it
+ */
+QStringView unquoted(QStringView value)
+{
+    if(value.size() >= 2 && (value.front() == '"' || value.front() == '\'') &&
+            value.back() == value.front())
+        return value.mid(1, value.size() - 2);
+    return value;
+}
+
+/**
+ * @brief The MapVisitor struct
+ *        writes the nodes of a GroupedWalk as maps
+ *        the values are the minified ones
+ */
+template<typename Node>
+struct MapVisitor
+{
+    explicit MapVisitor(CBORWriter &writer) : writer(writer), text_key("@text") {}
+
+    bool start(Node node, int, bool)
+    {
+        if(node->attributes_size() || !node->is_leaf())
+            return true;
+
+        const NodeValue value(node->value(storage), true);
+        if(value.is_empty())
+            writer.null();
+        else
+            writer.text(value.text(text));
+        return false;
+    }
+
+    // the size of the map is known once the children are grouped
+    void start_object(Node node, int, int groups)
+    {
+        const NodeValue value(node->value(storage), true);
+        writer.start_map(node->attributes_size() + groups + (value.is_empty() ? 0 : 1));
+
+        for(int i = 0; i < node->attributes_size(); ++i) {
+            key.resize(0);
+            key += '#';
+            key += node->attribute_key(i);
+            writer.text(key);
+            writer.text(unquoted(node->attribute_value(i)));
+        }
+    }
+
+    void member(Node child, int) { writer.text(child->tag()); }
+
+    void start_array(Node first, int size, int)
+    {
+        writer.text(first->tag());
+        writer.start_array(size);
+    }
+
+    void array_item(int) {}
+    void end_array(int) {}
+
+    void end_object(Node node, int)
+    {
+        const NodeValue value(node->value(storage), true);
+        if(!value.is_empty()) {
+            writer.text(text_key);
+            writer.text(value.text(text));
+        }
+    }
+
+    CBORWriter &writer;
+    const QString text_key;
+    QString key;
+    // a value loaded from the source is read into it
+    QString storage;
+    // a value which isn't written as it's viewed
+    QString text;
+};
+
+} // namespace
+
+QByteArray CBOR::xml2cbor(const XMLTree &tree)
+{
+    CBORWriter writer;
+    xml2cbor_helper(tree.root(), writer);
+    return writer.bytes();
+}
+
+QByteArray CBOR::xml2cbor(const XMLDocument &document)
+{
+    CBORWriter writer;
+    xml2cbor_helper(document.root(), writer);
+    return writer.bytes();
+}
+
+void CBOR::xml2cbor(const XMLTree &tree, QIODevice *device)
+{
+    CBORWriter writer(device);
+    xml2cbor_helper(tree.root(), writer);
+    writer.flush();
+}
+
+void CBOR::xml2cbor(const XMLDocument &document, QIODevice *device)
+{
+    CBORWriter writer(device);
+    xml2cbor_helper(document.root(), writer);
+    writer.flush();
+}
+
+template<typename Node>
+void CBOR::xml2cbor_helper(Node root, CBORWriter &writer)
+{
+    if(!root) {
+        writer.start_map(0);
+        return;
+    }
+
+    MapVisitor<Node> visitor(writer);
+    GroupedWalk<Node> walk;
+    writer.start_map(1);
+    writer.text(root->tag());
+    walk.walk(root, 1, false, visitor);
+}
+
+void CBOR::cbor2xml(const QByteArray &input, XMLTree &tree)
+{
+    const uchar *data = reinterpret_cast<const uchar *>(input.constData());
+    const int n = input.size();
+    int pos = 0;
+
+    auto error = [&](const char *message) {
+        return QString(message) + " at " + QString::number(pos);
+    };
+
+    // the major type and the argument of the item at pos
+    auto head = [&](uchar &major, quint64 &value) {
+        if(pos >= n)
+            throw error("Unexpected end");
+        const uchar initial = data[pos++];
+        major = initial >> 5;
+        const uchar info = initial & 0x1F;
+        if(info < 24) {
+            value = info;
+            return;
+        }
+        if(info > 27)
+            throw error("Unsupported item");
+
+        const int bytes = 1 << (info - 24);
+        if(n - pos < bytes)
+            throw error("Unexpected end");
+        value = 0;
+        for(int i = 0; i < bytes; ++i)
+            value = value << 8 | data[pos++];
+    };
+
+    auto read_text = [&](quint64 length) {
+        if(quint64(n - pos) < length)
+            throw error("Unexpected end");
+        const QString text = QString::fromUtf8(input.constData() + pos, int(length));
+        pos += int(length);
+        return text;
+    };
+
+    // a text string, a number or a simple value as text
+    // null is an empty value
+    struct Scalar {
+        QString text;
+        bool null;
+    };
+    auto read_scalar = [&](uchar major, quint64 value) {
+        switch(major) {
+        case 0:
+            return Scalar{QString::number(qulonglong(value)), false};
+        case 1:
+            if(value > quint64(std::numeric_limits<qint64>::max()))
+                throw error("Unsupported item");
+            return Scalar{QString::number(qlonglong(-1 - qint64(value))), false};
+        case 3:
+            return Scalar{read_text(value), false};
+        case 7:
+            if(value == 20 || value == 21)
+                return Scalar{value == 21 ? QString("true") : QString("false"), false};
+            if(value == 22 || value == 23)
+                return Scalar{QString(), true};
+            break;
+        default:
+            break;
+        }
+        throw error("Unsupported item");
+    };
+
+    // an open map or array, the document is the map
+    // around the root which isn't an element
+    struct Frame {
+        bool array;
+        quint64 remaining;
+        bool element;
+        // the tag of the items of an array
+        QString tag;
+        bool children;
+        QString value;
+    };
+    QStack<Frame> open;
+
+    XMLTree::ValueBuilder builder(&tree);
+
+    // the element of a member or an item whose head is read
+    auto element = [&](const QString &tag, uchar major, quint64 value) {
+        for(int k = open.size() - 1; k >= 0; --k) {
+            if(!open[k].array) {
+                open[k].children = true;
+                break;
+            }
+        }
+
+        if(major == 5) {
+            builder.start_tag(tag);
+            open.push({false, value, true, QString(), false, QString()});
+        } else if(major == 4) {
+            const Frame items = {true, value, false, tag, false, QString()};
+            open.push(items);
+        } else {
+            builder.start_tag(tag);
+            const Scalar scalar = read_scalar(major, value);
+            if(scalar.null) {
+                builder.self_close();
+            } else {
+                builder.close(scalar.text);
+                builder.end_tag();
+            }
+        }
+    };
+
+    if(n == 0)
+        return;
+
+    uchar major;
+    quint64 value;
+    head(major, value);
+    if(major != 5)
+        throw error("Expected a map");
+    open.push({false, value, false, QString(), false, QString()});
+
+    while(open.size()) {
+        Frame &frame = open.top();
+        if(frame.remaining == 0) {
+            if(frame.element) {
+                if(!frame.children && frame.value.isEmpty()) {
+                    builder.self_close();
+                } else {
+                    builder.close(frame.value);
+                    builder.end_tag();
+                }
+            }
+            open.pop();
+            continue;
+        }
+        --frame.remaining;
+
+        if(frame.array) {
+            head(major, value);
+            element(frame.tag, major, value);
+            continue;
+        }
+
+        head(major, value);
+        if(major != 3)
+            throw error("Expected a text key");
+        const QString key = read_text(value);
+
+        head(major, value);
+        if(key.startsWith('#') || key == "@text") {
+            if(!frame.element)
+                throw error("Expected an element");
+            const Scalar scalar = read_scalar(major, value);
+            if(key == "@text") {
+                frame.value = scalar.text;
+            } else {
+                // the quote which isn't in the value
+                const QChar quote = scalar.text.contains('"') ? '\'' : '"';
+                builder.attribute(QStringView(key).mid(1), quote + scalar.text + quote);
+            }
+        } else {
+            element(key, major, value);
+        }
+    }
+
+    if(pos < n)
+        throw error("Unexpected bytes after the document");
+}
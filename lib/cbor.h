@@ -0,0 +1,79 @@
+#ifndef CBOR_H
+#define CBOR_H
+
+#include <QByteArray>
+#include "lib/xmldocument.h"
+#include "lib/xmltree.h"
+
+class CBORWriter;
+class QIODevice;
+
+/**
+ * @brief The CBOR class
+ *        Binary export of the trees with the mapping of JSON::xml2json
+ *        a node with attributes or children is a map of "#key"
+ *        to the attribute values, the tags of its children to
+ *        a child or an array of the children with the tag
+ *        and "@text" to its value, any other node is its value
+ *        as a text string or null when it's empty
+ *
+ *        the values are the minified ones of xml2json and
+ *        the attribute values are without their quotes
+ *        like a JSON parser reads them
+ */
+class CBOR
+{
+public:
+    /**
+     * @brief xml2cbor
+     * @return the CBOR of the tree
+     * @complexity O(size of(tree))
+     */
+    static QByteArray xml2cbor(const XMLTree& tree);
+
+    /**
+     * @brief xml2cbor
+     *        the same for a flat document
+     */
+    static QByteArray xml2cbor(const XMLDocument& document);
+
+    /**
+     * @brief xml2cbor
+     *        write the CBOR to the device as it's encoded
+     * @param tree
+     * @param device an open writable device like a QFile
+     */
+    static void xml2cbor(const XMLTree& tree, QIODevice *device);
+
+    /**
+     * @brief xml2cbor
+     *        the same for a flat document
+     */
+    static void xml2cbor(const XMLDocument& document, QIODevice *device);
+
+    /**
+     * @brief cbor2xml
+     *        build the tree from CBOR with the same mapping
+     *        the attribute values are quoted again
+     *        numbers and booleans are values like text strings
+     *        it throws QString if the CBOR is malformed or has
+     *        items other than maps, arrays, text, numbers,
+     *        booleans and null
+     * @param input
+     * @param tree replaced with the built tree
+     * @complexity O(length of(input))
+     */
+    static void cbor2xml(const QByteArray &input, XMLTree &tree);
+
+private:
+    /**
+     * @brief xml2cbor_helper
+     *        write the root of a tree or a document
+     *        and the nodes under it without recursion
+     * @param root pointer to XMLNode or XMLDocument::Node
+     */
+    template<typename Node>
+    static void xml2cbor_helper(Node root, CBORWriter &writer);
+};
+
+#endif // CBOR_H
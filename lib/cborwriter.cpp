@@ -0,0 +1,114 @@
+#include "cborwriter.h"
+
+#include <QIODevice>
+
+namespace {
+
+// the buffer is written to the device once it's this large
+constexpr int flush_size = 1 << 16;
+
+} // namespace
+
+CBORWriter::CBORWriter(QIODevice *device)
+    : m_device(device),
+      m_buffer()
+{
+    if(m_device)
+        m_buffer.reserve(flush_size + 64);
+}
+
+CBORWriter::~CBORWriter()
+{
+    flush();
+}
+
+void CBORWriter::head(uchar major, quint64 value)
+{
+    const uchar type = uchar(major << 5);
+    if(value < 24) {
+        m_buffer.append(char(type | value));
+        return;
+    }
+
+    // the argument follows in 1, 2, 4 or 8 bytes big endian
+    int bytes = 8;
+    uchar info = 27;
+    if(value <= 0xFF) {
+        bytes = 1;
+        info = 24;
+    } else if(value <= 0xFFFF) {
+        bytes = 2;
+        info = 25;
+    } else if(value <= 0xFFFFFFFF) {
+        bytes = 4;
+        info = 26;
+    }
+
+    m_buffer.append(char(type | info));
+    for(int i = bytes - 1; i >= 0; --i)
+        m_buffer.append(char(uchar(value >> (8 * i))));
+}
+
+void CBORWriter::text(QStringView text)
+{
+    const ushort *p = reinterpret_cast<const ushort *>(text.data());
+    const int n = int(text.size());
+
+    // the length of the UTF-8 goes first
+    // an unpaired surrogate is written as U+FFFD
+    int length = 0;
+    for(int i = 0; i < n; ++i) {
+        const ushort c = p[i];
+        if(c < 0x80) {
+            length += 1;
+        } else if(c < 0x800) {
+            length += 2;
+        } else if(QChar::isHighSurrogate(c) && i + 1 < n && QChar::isLowSurrogate(p[i + 1])) {
+            length += 4;
+            ++i;
+        } else {
+            length += 3;
+        }
+    }
+    head(3, quint64(length));
+
+    const int begin = m_buffer.size();
+    m_buffer.resize(begin + length);
+    uchar *out = reinterpret_cast<uchar *>(m_buffer.data()) + begin;
+    for(int i = 0; i < n; ++i) {
+        uint c = p[i];
+        if(c < 0x80) {
+            *out++ = uchar(c);
+            continue;
+        }
+        if(c < 0x800) {
+            *out++ = uchar(0xC0 | (c >> 6));
+            *out++ = uchar(0x80 | (c & 0x3F));
+            continue;
+        }
+        if(QChar::isHighSurrogate(c) && i + 1 < n && QChar::isLowSurrogate(p[i + 1])) {
+            c = QChar::surrogateToUcs4(ushort(c), p[++i]);
+            *out++ = uchar(0xF0 | (c >> 18));
+            *out++ = uchar(0x80 | ((c >> 12) & 0x3F));
+            *out++ = uchar(0x80 | ((c >> 6) & 0x3F));
+            *out++ = uchar(0x80 | (c & 0x3F));
+            continue;
+        }
+        if(QChar::isSurrogate(c))
+            c = 0xFFFD;
+        *out++ = uchar(0xE0 | (c >> 12));
+        *out++ = uchar(0x80 | ((c >> 6) & 0x3F));
+        *out++ = uchar(0x80 | (c & 0x3F));
+    }
+
+    if(m_device && m_buffer.size() >= flush_size)
+        flush();
+}
+
+void CBORWriter::flush()
+{
+    if(!m_device || m_buffer.isEmpty())
+        return;
+    m_device->write(m_buffer);
+    m_buffer.resize(0);
+}
@@ -0,0 +1,83 @@
+#ifndef CBORWRITER_H
+#define CBORWRITER_H
+
+#include <QByteArray>
+#include <QStringView>
+
+class QIODevice;
+
+/**
+ * @brief The CBORWriter class
+ *        Writes CBOR (RFC 8949) items one at a time
+ *        maps and arrays are written with their sizes first
+ *        and their items after them, so nothing is held back
+ *
+ *        the bytes are written to a buffer which is flushed
+ *        to the device as it fills, without a device
+ *        they stay in the buffer
+ */
+class CBORWriter
+{
+public:
+    explicit CBORWriter(QIODevice *device = nullptr);
+
+    /**
+      * Destructor
+      * flushes the buffer to the device
+      */
+    ~CBORWriter();
+
+    CBORWriter(const CBORWriter &) = delete;
+    CBORWriter &operator=(const CBORWriter &) = delete;
+
+    /**
+     * @brief start_map
+     *        a map of size pairs, the keys and the values
+     *        are the next 2 * size items
+     */
+    void start_map(int size) { head(5, quint64(size)); }
+
+    /**
+     * @brief start_array
+     *        an array of the next size items
+     */
+    void start_array(int size) { head(4, quint64(size)); }
+
+    /**
+     * @brief text
+     *        a text string encoded in UTF-8 as it's written
+     * @complexity O(length of(text))
+     */
+    void text(QStringView text);
+
+    /**
+     * @brief null
+     *        the simple value null
+     */
+    void null() { m_buffer.append(char(0xF6)); }
+
+    /**
+     * @brief flush
+     *        write the buffer to the device
+     */
+    void flush();
+
+    /**
+     * @brief bytes
+     * @return the written bytes when there's no device
+     */
+    const QByteArray &bytes() const { return m_buffer; }
+
+private:
+    /**
+     * @brief head
+     *        the major type and the argument of an item
+     *        in the fewest bytes
+     */
+    void head(uchar major, quint64 value);
+
+    QIODevice *m_device;
+    QByteArray m_buffer;
+};
+
+#endif // CBORWRITER_H
@@ -0,0 +1,183 @@
+#ifndef CHILDGROUPS_H
+#define CHILDGROUPS_H
+
+#include <QStack>
+#include <QVector>
+
+/**
+ * @brief The ChildGroups class
+ *        The groups of the children of the objects being written
+ *        by the converters, the children of a node are grouped
+ *        by the ids of their interned tags in the order the tags
+ *        first occur, the groups of an object are added after
+ *        those of its ancestors and released when it's closed
+ *        so the arrays are reused and only grow with the widest objects
+ */
+template<typename Node>
+class ChildGroups
+{
+public:
+    /**
+     * @brief group
+     *        add the groups of the children of the node
+     * @return index of the first of them
+     * @complexity O(number of children)
+     */
+    int group(Node node)
+    {
+        const int first = m_begin.size();
+
+        // count the children of every tag, a new tag opens a group
+        for(Node child = node->first_child(); child; child = child->next_sibling()) {
+            const int tag = child->tag_id();
+            while(m_group.size() <= tag)
+                m_group.push_back(-1);
+            if(m_group[tag] < 0) {
+                m_group[tag] = m_end.size();
+                m_begin.push_back(0);
+                m_end.push_back(0);
+            }
+            ++m_end[m_group[tag]];
+        }
+
+        // the end of a group is where its next child goes
+        int offset = m_items.size();
+        for(int i = first; i < m_begin.size(); ++i) {
+            const int size = m_end[i];
+            m_begin[i] = m_end[i] = offset;
+            offset += size;
+        }
+
+        m_items.resize(offset);
+        for(Node child = node->first_child(); child; child = child->next_sibling())
+            m_items[m_end[m_group[child->tag_id()]]++] = child;
+
+        for(int i = first; i < m_begin.size(); ++i)
+            m_group[m_items[m_begin[i]]->tag_id()] = -1;
+
+        return first;
+    }
+
+    /**
+     * @brief release
+     *        remove the groups from first on
+     *        the arrays keep their capacity
+     */
+    void release(int first)
+    {
+        if(first < m_begin.size())
+            m_items.resize(m_begin[first]);
+        m_begin.resize(first);
+        m_end.resize(first);
+    }
+
+    int size() const { return m_begin.size(); }
+    int size(int group) const { return m_end[group] - m_begin[group]; }
+    Node item(int group, int i) const { return m_items[m_begin[group] + i]; }
+
+private:
+    // the group of every tag id while grouping, otherwise -1
+    QVector<int> m_group;
+    // group i is the items in [begin, end)
+    QVector<int> m_begin;
+    QVector<int> m_end;
+    QVector<Node> m_items;
+};
+
+/**
+ * @brief The GroupedWalk class
+ *        The walk of the converters over a node and the nodes under it
+ *        without recursion, the children of an object are visited
+ *        a group of ChildGroups at a time, a group of one child
+ *        is a member and a larger one is an array
+ *        the stack and the groups are kept between the walks
+ *
+ *        the visitor has
+ *        bool start(Node node, int depth, bool array_item)
+ *        which writes a node that isn't an object or returns true
+ *        void start_object(Node node, int depth, int groups)
+ *        void member(Node child, int depth)
+ *        void start_array(Node first, int size, int depth)
+ *        void array_item(int depth)
+ *        void end_array(int depth)
+ *        void end_object(Node node, int depth)
+ *        the depth of a member or an array is the one of its object
+ */
+template<typename Node>
+class GroupedWalk
+{
+public:
+    /**
+     * @brief walk
+     *        visit the node and the nodes under it
+     * @complexity O(size of(node))
+     */
+    template<typename Visitor>
+    void walk(Node node, int depth, bool array_item, Visitor &visitor)
+    {
+        if(!node || !visitor.start(node, depth, array_item))
+            return;
+        push(node, depth, visitor);
+
+        while(m_open.size()) {
+            Frame &frame = m_open.top();
+
+            if(frame.group == frame.end) {
+                const Frame object = m_open.pop();
+                visitor.end_object(object.node, object.depth);
+                m_groups.release(object.first);
+                continue;
+            }
+
+            // starting a child pushes it, the frame isn't used after it
+            const int group = frame.group;
+            const int size = m_groups.size(group);
+            const int child_depth = frame.depth + 1;
+            Node child;
+            if(size == 1) {
+                child = m_groups.item(group, 0);
+                visitor.member(child, frame.depth);
+                ++frame.group;
+            } else if(frame.child < size) {
+                if(frame.child == 0)
+                    visitor.start_array(m_groups.item(group, 0), size, frame.depth);
+                visitor.array_item(frame.depth);
+                child = m_groups.item(group, frame.child++);
+            } else {
+                visitor.end_array(frame.depth);
+                ++frame.group;
+                frame.child = 0;
+                continue;
+            }
+
+            if(visitor.start(child, child_depth, size > 1))
+                push(child, child_depth, visitor);
+        }
+    }
+
+private:
+    // an object which is still visited
+    struct Frame {
+        Node node;
+        int depth;
+        // the groups of the children are [first, end)
+        int first;
+        int end;
+        int group;
+        int child;
+    };
+
+    template<typename Visitor>
+    void push(Node node, int depth, Visitor &visitor)
+    {
+        const int first = m_groups.group(node);
+        visitor.start_object(node, depth, m_groups.size() - first);
+        m_open.push({node, depth, first, m_groups.size(), first, 0});
+    }
+
+    // empty between the walks
+    QStack<Frame> m_open;
+    ChildGroups<Node> m_groups;
+};
+
+#endif // CHILDGROUPS_H
@@ -0,0 +1,105 @@
+#ifndef DUMPLAYOUT_H
+#define DUMPLAYOUT_H
+
+#include <QChar>
+#include <QString>
+#include <QStringView>
+
+#include "lib/indenttable.h"
+
+/**
+ * The layouts of the XML serializers
+ * the tree, the document and the formatter are written
+ * through the same layout, so their texts can't drift apart
+ * the serializers are instantiated for every layout
+ * so their loops don't check the layout
+ */
+
+/**
+ * @brief The MinifiedLayout struct
+ *        no indentation nor line ends
+ *        the white spaces of the values are simplified
+ */
+struct MinifiedLayout
+{
+    template<typename Output>
+    void indent(Output &, int) {}
+
+    template<typename Output>
+    void end_line(Output &) {}
+
+    /**
+     * @brief write_value
+     *        the words of the value separated by single spaces
+     *        like QString::simplified, nothing if it's only spaces
+     */
+    template<typename Output>
+    void write_value(Output &output, QStringView value, int)
+    {
+        bool separate = false;
+        int i = 0;
+        while(i < value.size()) {
+            if(value[i].isSpace()) {
+                ++i;
+                continue;
+            }
+            const int begin = i;
+            while(i < value.size() && !value[i].isSpace())
+                ++i;
+            if(separate)
+                output << QChar(' ');
+            output << value.mid(begin, i - begin);
+            separate = true;
+        }
+    }
+};
+
+/**
+ * @brief The IndentedLayout struct
+ *        a node on every line indented by its depth
+ *        every line of a value is trimmed and indented
+ *        one level deeper than its node
+ */
+struct IndentedLayout
+{
+    IndentedLayout(int spaces, QChar fill) : indents(spaces, fill) {}
+
+    template<typename Output>
+    void indent(Output &output, int depth)
+    {
+        output << indents(depth);
+    }
+
+    template<typename Output>
+    void end_line(Output &output)
+    {
+        output << "\n";
+    }
+
+    /**
+     * @brief write_value
+     *        every line of the value, nothing if it's empty
+     */
+    template<typename Output>
+    void write_value(Output &output, QStringView value, int depth)
+    {
+        if(value.isEmpty())
+            return;
+
+        const QString &indent = indents(depth);
+        int begin = 0;
+        while(true) {
+            int end = int(value.indexOf('\n', begin));
+            if(end < 0)
+                end = int(value.size());
+            output << indent << value.mid(begin, end - begin).trimmed() << "\n";
+            if(end == value.size())
+                break;
+            begin = end + 1;
+        }
+    }
+
+    IndentTable indents;
+};
+
+#endif // DUMPLAYOUT_H
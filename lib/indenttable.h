@@ -0,0 +1,41 @@
+#ifndef INDENTTABLE_H
+#define INDENTTABLE_H
+
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief The IndentTable class
+ *        Indentation strings of the serializers by depth
+ *        every depth is built once and shared by all the lines
+ *        written at it, a negative number of spaces is no indentation
+ *        a level is the given number of fill characters
+ */
+class IndentTable
+{
+public:
+    explicit IndentTable(int spaces, QChar fill = ' ')
+        : m_spaces(qMax(spaces, 0)),
+          m_fill(fill),
+          m_indents() {}
+
+    /**
+     * @brief operator ()
+     * @return the indentation of the given depth
+     *         valid until a deeper one is requested
+     * @complexity amortized O(1)
+     */
+    const QString &operator()(int depth)
+    {
+        while(m_indents.size() <= depth)
+            m_indents.push_back(QString(m_spaces * m_indents.size(), m_fill));
+        return m_indents[depth];
+    }
+
+private:
+    int m_spaces;
+    QChar m_fill;
+    QVector<QString> m_indents;
+};
+
+#endif // INDENTTABLE_H
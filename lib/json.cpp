@@ -1,103 +1,789 @@
 #include "json.h"
+#include "childgroups.h"
+#include "indenttable.h"
+#include "nodevalue.h"
+#include "textoutput.h"
+#include "xmlreader.h"
 
-JSON::JSON()
+#include <QSet>
+#include <QStack>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+namespace {
+
+// trees with fewer nodes are converted on the calling thread
+constexpr int parallel_threshold = 1 << 16;
+// the subtrees are converted in a few chunks per thread
+// so a thread with larger ones doesn't hold up the others
+constexpr int chunks_per_thread = 4;
+
+/**
+ * @brief presized_text
+ * @return the text written by the function
+ *         sized first to allocate it at once
+ */
+template<typename Write>
+QString presized_text(Write write)
 {
+    TextSizeOutput sizes;
+    write(sizes);
+
+    QString builder;
+    builder.resize(sizes.size());
+    TextBufferOutput output(builder.data());
+    write(output);
+    Q_ASSERT(output.end() == builder.constData() + builder.size());
 
+    return builder;
 }
 
-QString JSON::xml2json(const XMLTree &tree, int spaces)
+/**
+ * @brief The NoSplit struct
+ *        writes every node on the calling thread
+ */
+struct NoSplit
 {
-    QString builder;
-    QTextStream ts(&builder);
-    QString local_indent;
-    local_indent.reserve(spaces + 2);
-    for(int i = 0; i < spaces; i++)
-        local_indent += " ";
+    template<typename Node>
+    bool operator()(Node, int, bool) const { return false; }
+};
 
-    ts << "{" << (spaces >= 0 ? "\n" : "" ) << local_indent
-       << tree.root()->tag() << ":" << (spaces >= 0 ? " " : "" );
+/**
+ * @brief The ObjectVisitor struct
+ *        writes the nodes of a GroupedWalk as xml2json does
+ *        a node which split takes is written somewhere else
+ */
+template<typename Node, typename Output, typename Split>
+struct ObjectVisitor
+{
+    bool start(Node node, int depth, bool array_item)
+    {
+        if(split(node, depth, array_item))
+            return false;
+        if(node->attributes_size() || !node->is_leaf())
+            return true;
 
-    xml2json_helper(tree.root(), spaces, 1, 0, ts);
+        const NodeValue value(node->value(storage), spaces < 0);
+        if(array_item)
+            output << indents(1);
+        output << "\"";
+        if(value.is_empty())
+            output << "null";
+        else
+            value.write(output);
+        output << "\"," << end_line;
+        return false;
+    }
 
-    ts << "}";
+    void start_object(Node node, int depth, int)
+    {
+        output << "{" << end_line;
+        const QString &indent = indents(depth + 1);
+        for(int i = 0; i < node->attributes_size(); ++i) {
+            output << indent << "#" << node->attribute_key(i) << ":" << space
+                   << node->attribute_value(i) << "," << end_line;
+        }
+    }
 
-    return builder;
-}
+    void member(Node child, int depth)
+    {
+        output << indents(depth + 1) << child->tag() << ":" << space;
+    }
 
-void JSON::xml2json_helper(const XMLNode *node,
-                           int spaces,
-                           int depth,
-                           bool array_parent,
-                           QTextStream &output)
-{
-    if(node == nullptr)
-        return;
+    void start_array(Node first, int, int depth)
+    {
+        output << indents(depth + 1) << first->tag() << ":" << space << "[" << end_line;
+    }
 
-    QString space;
-    QString indent;
-    QString end_line;
-    QString indent_less;
-    QString local_indent;
+    void array_item(int depth) { output << indents(depth + 1); }
+
+    void end_array(int depth) { output << indents(depth + 1) << "]," << end_line; }
+
+    void end_object(Node node, int depth)
+    {
+        // the value is written after the children
+        const NodeValue value(node->value(storage), spaces < 0);
+        if(!value.is_empty()) {
+            output << indents(depth + 1) << "@text:" << space << "\"";
+            value.write(output);
+            output << "\"," << end_line;
+        }
+        output << indents(depth) << "}," << end_line;
+    }
 
-    if(spaces >= 0) {
-        local_indent.reserve(spaces + 2);
-        for(int i = 0; i < spaces; i++)
-            local_indent += " ";
+    int spaces;
+    IndentTable &indents;
+    const QString &space;
+    const QString &end_line;
+    QString &storage;
+    Output &output;
+    Split &split;
+};
 
-        indent_less.reserve(spaces * depth + 2);
-        indent.reserve(spaces * (depth + 1) + 2);
-        for(int i = 0; i < depth; i++)
-            indent_less += local_indent;
+/**
+ * @brief json_unescape
+ * @return the characters of a JSON string without its escapes
+ */
+QString json_unescape(QStringView text)
+{
+    QString value;
+    value.reserve(int(text.size()));
+    for(int i = 0; i < text.size(); ++i) {
+        if(text[i] != '\\' || i + 1 == text.size()) {
+            value += text[i];
+            continue;
+        }
 
-        indent = indent_less + local_indent;
-        space = " ";
-        end_line = "\n";
+        const QChar c = text[++i];
+        switch(c.unicode()) {
+        case 'b': value += QChar('\b'); break;
+        case 'f': value += QChar('\f'); break;
+        case 'n': value += QChar('\n'); break;
+        case 'r': value += QChar('\r'); break;
+        case 't': value += QChar('\t'); break;
+        case 'u': {
+            // four hex digits, a surrogate pair is two escapes
+            ushort code = 0;
+            int digits = 0;
+            for(; digits < 4 && i + 1 + digits < text.size(); ++digits) {
+                const ushort digit = text[i + 1 + digits].unicode();
+                if(digit >= '0' && digit <= '9')
+                    code = ushort(code * 16 + digit - '0');
+                else if((digit | 0x20) >= 'a' && (digit | 0x20) <= 'f')
+                    code = ushort(code * 16 + (digit | 0x20) - 'a' + 10);
+                else
+                    break;
+            }
+            if(digits == 4) {
+                value += QChar(code);
+                i += 4;
+            } else {
+                value += c;
+            }
+            break;
+        }
+        default:
+            // the quote, the backslash and the slash are themselves
+            value += c;
+            break;
+        }
     }
+    return value;
+}
 
-    QString value = node->value();
-    QRegExp comments("<!--[\\w\\W]+-->");
-    value.remove(comments);
-    if(spaces < 0)
-        value = value.simplified();
+/**
+ * @brief The PendingOutput class
+ *        writes to a text stream, or to the last pending text
+ *        while there is one, a pending text is taken back
+ *        once it's known where it goes
+ */
+class PendingOutput
+{
+public:
+    explicit PendingOutput(QTextStream &stream) : m_stream(stream) {}
 
-    if(!node->attributes_size() && node->is_leaf()) {
-        if(array_parent) output << local_indent;
-        output << "\"" << (value == "" ? "null" : value) <<  "\"," << end_line;
-        return;
+    PendingOutput &operator<<(QStringView text)
+    {
+        if(m_pending.isEmpty())
+            m_stream << text;
+        else
+            m_pending.top().append(text.data(), int(text.size()));
+        return *this;
     }
 
-    output << "{" << end_line;
+    PendingOutput &operator<<(const QString &text) { return *this << QStringView(text); }
 
-    for(const auto& item : node->attributes()) {
-        output << indent  << "#" << item.key << ":" << space
-                 << item.value << "," << end_line;
+    PendingOutput &operator<<(const char *text)
+    {
+        if(m_pending.isEmpty())
+            m_stream << text;
+        else
+            m_pending.top() += QLatin1String(text);
+        return *this;
+    }
+
+    PendingOutput &operator<<(QChar c)
+    {
+        if(m_pending.isEmpty())
+            m_stream << c;
+        else
+            m_pending.top() += c;
+        return *this;
     }
 
-    HashMap<QString, QList<XMLNode *>> children;
+    /**
+     * @brief hold
+     *        keep the text written from now on in a new pending text
+     */
+    void hold() { m_pending.push(QString()); }
+
+    /**
+     * @brief take
+     * @return the last pending text, what's written
+     *         then goes where it went before it
+     */
+    QString take() { return m_pending.pop(); }
+
+private:
+    QTextStream &m_stream;
+    QStack<QString> m_pending;
+};
+
+} // namespace
+
+JSON::JSON()
+{
+
+}
 
-    for(const auto& child: qAsConst((const QList<XMLNode *>&)node->children())) {
-        if(children.contains(child->tag()))
-            children[child->tag()].append(child);
+QString JSON::xml2json(const XMLTree &tree, int spaces)
+{
+    if(tree.size() >= parallel_threshold)
+        return xml2json_parallel(tree, spaces);
+    return xml2json_string(tree.root(), spaces);
+}
+
+QString JSON::xml2json(const XMLDocument &document, int spaces)
+{
+    if(document.size() >= parallel_threshold)
+        return xml2json_parallel(document, spaces);
+    return xml2json_string(document.root(), spaces);
+}
+
+QString JSON::xml2json_parallel(const XMLTree &tree, int spaces, int depth, int threads)
+{
+    // reading a lazy tree builds its nodes
+    if(tree.is_lazy())
+        return xml2json_string(tree.root(), spaces);
+    return xml2json_split(tree.root(), spaces, depth, threads);
+}
+
+QString JSON::xml2json_parallel(const XMLDocument &document, int spaces, int depth, int threads)
+{
+    return xml2json_split(document.root(), spaces, depth, threads);
+}
+
+void JSON::xml2json(const XMLTree &tree, QIODevice *device, int spaces)
+{
+    QTextStream ts(device);
+    ts.setCodec("UTF-8");
+    TextStreamOutput output(ts);
+    NoSplit split;
+    xml2json_root(tree.root(), spaces, output, split);
+    ts.flush();
+}
+
+void JSON::xml2json(const XMLDocument &document, QIODevice *device, int spaces)
+{
+    QTextStream ts(device);
+    ts.setCodec("UTF-8");
+    TextStreamOutput output(ts);
+    NoSplit split;
+    xml2json_root(document.root(), spaces, output, split);
+    ts.flush();
+}
+
+void JSON::xml2json(QIODevice *input, QIODevice *output, int spaces)
+{
+    XMLReader reader(input);
+    QTextStream ts(output);
+    ts.setCodec("UTF-8");
+    PendingOutput out(ts);
+
+    IndentTable indents(spaces);
+    const QString space = spaces >= 0 ? " " : "";
+    const QString end_line = spaces >= 0 ? "\n" : "";
+
+    // an open node, its start is written once it has a child
+    // or it's closed, then it's known if it's an object
+    struct Element {
+        QList<MPair<QString, QString>> attributes;
+        // the text of the node as it's read
+        QString value;
+        bool object;
+        bool array_item;
+        // the run of children with the same tag being written
+        // the text of its first node is pending until the next
+        // sibling starts or the node is closed
+        QString run;
+        int run_size;
+        bool run_leaf;
+        // the tags of the runs which are over
+        QSet<QString> tags;
+    };
+    const Element blank = {QList<MPair<QString, QString>>(), QString(), false, false,
+                           QString(), 0, false, QSet<QString>()};
+
+    // the document is an object around the root
+    // the depth of a node is its index
+    QStack<Element> open;
+    open.push(blank);
+    open.top().object = true;
+    out << "{" << end_line;
+
+    auto start_object = [&](Element &element, int depth) {
+        if(element.object)
+            return;
+        out << "{" << end_line;
+        const QString &indent = indents(depth + 1);
+        for(const auto& item : element.attributes)
+            out << indent << "#" << item.key << ":" << space << item.value << "," << end_line;
+        element.object = true;
+    };
+
+    auto end_run = [&](Element &element, int depth) {
+        if(element.run_size == 1) {
+            const QString item = out.take();
+            out << indents(depth + 1) << element.run << ":" << space << item;
+        } else if(element.run_size > 1) {
+            out << indents(depth + 1) << "]," << end_line;
+        }
+        if(element.run_size)
+            element.tags.insert(element.run);
+        element.run_size = 0;
+    };
+
+    auto write_value = [&](const NodeValue &value) {
+        out << "\"";
+        if(value.is_empty())
+            out << "null";
         else
-            children.insert(child->tag(), QList({child}));
+            value.write(out);
+        out << "\"," << end_line;
+    };
+
+    while(reader.next() != XMLReader::EndDocument) {
+        switch(reader.event()) {
+        case XMLReader::StartElement: {
+            const int depth = open.size() - 1;
+            Element &parent = open.top();
+            const QString &indent = indents(depth + 1);
+            bool array_item = false;
+
+            if(depth == 0) {
+                // the root is the only node of its run
+                // so it's written straight away
+                if(parent.run_size)
+                    throw QString("Expected a single root element");
+                out << indent << reader.name() << ":" << space;
+                parent.run_size = 1;
+            } else if(parent.run_size && parent.run == reader.name()) {
+                // the second node makes the run an array
+                if(parent.run_size == 1) {
+                    const QString item = out.take();
+                    out << indent << parent.run << ":" << space << "[" << end_line << indent;
+                    if(parent.run_leaf)
+                        out << indents(1);
+                    out << item;
+                }
+                ++parent.run_size;
+                out << indent;
+                array_item = true;
+            } else {
+                start_object(parent, depth);
+                end_run(parent, depth);
+                // the groups are the runs, a tag can't have two of them
+                if(parent.tags.contains(reader.name()))
+                    throw QString("The siblings with the tag " + reader.name() +
+                                  " aren't next to each other");
+                parent.run = reader.name();
+                parent.run_size = 1;
+                out.hold();
+            }
+
+            open.push(blank);
+            open.top().array_item = array_item;
+            break;
+        }
+
+        case XMLReader::Attribute:
+            open.top().attributes.append(MPair<QString, QString>(reader.name(), reader.value()));
+            break;
+
+        case XMLReader::Text:
+            open.top().value = reader.value();
+            break;
+
+        case XMLReader::EndElement: {
+            Element element = open.pop();
+            const int depth = open.size();
+            const NodeValue value(element.value, spaces < 0);
+            const bool leaf = !element.object && element.attributes.isEmpty();
+            open.top().run_leaf = leaf;
+
+            if(leaf) {
+                if(element.array_item)
+                    out << indents(1);
+                write_value(value);
+                break;
+            }
+
+            start_object(element, depth);
+            end_run(element, depth);
+            if(!value.is_empty()) {
+                out << indents(depth + 1) << "@text:" << space;
+                write_value(value);
+            }
+            out << indents(depth) << "}," << end_line;
+            break;
+        }
+
+        case XMLReader::EndDocument:
+            break;
+        }
     }
 
-    for(const auto& group : children) {
-        if(group.value.size() == 1) {
-            output << indent << group.key << ":" << space;
-            xml2json_helper(group.value[0], spaces, depth + 1, 0, output);
+    out << "}";
+    ts.flush();
+}
+
+void JSON::json2xml(QTextStream &input, XMLTree &tree)
+{
+    json2xml_helper(JSONStructuralIndex(input.readAll()), tree);
+}
+
+void JSON::json2xml(const QByteArray &input, XMLTree &tree)
+{
+    json2xml_helper(JSONStructuralIndex(QString::fromUtf8(input)), tree);
+}
+
+void JSON::json2xml_helper(const JSONStructuralIndex &index, XMLTree &tree)
+{
+    const QChar *text = index.text().constData();
+    const int n = index.text().size();
+    const int size = index.size();
+
+    auto error = [&](int i, const char *message) {
+        return QString(message) + " at " + QString::number(i < size ? index.position(i) : n);
+    };
+
+    // the indexed character, or a null one past the last
+    auto character = [&](int i) {
+        return i < size ? text[index.position(i)] : QChar();
+    };
+
+    // the first character of a key or a value
+    // which isn't a quote or a structural character
+    auto is_scalar = [&](int i) {
+        const QChar c = character(i);
+        return !c.isNull() && c != '"' && c != '{' && c != '}' &&
+               c != '[' && c != ']' && c != ':' && c != ',';
+    };
+
+    // the end of the text before the indexed position
+    auto end_before = [&](int i, int begin) {
+        int end = i < size ? index.position(i) : n;
+        while(end > begin && JSONStructuralIndex::is_space(text[end - 1]))
+            --end;
+        return end;
+    };
+
+    // a string ends with the quote before the next indexed character
+    // since the characters of the strings aren't indexed
+    // the view is the string without its quotes, unescaped in storage
+    auto read_string = [&](int &i, QString &storage) {
+        const int begin = index.position(i);
+        const int end = end_before(i + 1, begin);
+        if(end < begin + 2 || text[end - 1] != '"')
+            throw error(i, "Unterminated string");
+        ++i;
+
+        const QStringView value(text + begin + 1, end - begin - 2);
+        if(!value.contains('\\'))
+            return value;
+        storage = json_unescape(value);
+        return QStringView(storage);
+    };
+
+    // a key is a string or the characters before its ":"
+    // an unquoted one goes on over a ":" followed by more of it
+    // like "xml:base" and "soap:Envelope" do
+    auto read_key = [&](int &i, QString &storage) {
+        QStringView key;
+        if(character(i) == '"') {
+            key = read_string(i, storage);
+        } else if(is_scalar(i)) {
+            const int begin = index.position(i);
+            while(character(i + 1) == ':' && is_scalar(i + 2) && character(i + 3) == ':' &&
+                  index.position(i + 2) == index.position(i + 1) + 1)
+                i += 2;
+            key = QStringView(text + begin, end_before(i + 1, begin) - begin);
+            ++i;
+        } else {
+            throw error(i, "Expected a key");
+        }
+
+        if(character(i) != ':')
+            throw error(i, "Expected :");
+        ++i;
+        return key;
+    };
+
+    // a string or a scalar which runs to the next ",", "}" or "]"
+    // raw is the text as it's written with the quotes of a string
+    struct Value {
+        QStringView raw;
+        QStringView value;
+        bool null;
+    };
+    auto read_value = [&](int &i, QString &storage) {
+        const int begin = index.position(i);
+        if(character(i) == '"') {
+            const QStringView value = read_string(i, storage);
+            const QStringView raw(text + begin, end_before(i, begin) - begin);
+            return Value{raw, value, value == QLatin1String("null")};
+        }
+
+        if(!is_scalar(i))
+            throw error(i, "Expected a value");
+        ++i;
+        while(i < size && character(i) != ',' && character(i) != '}' && character(i) != ']')
+            ++i;
+        const QStringView raw(text + begin, end_before(i, begin) - begin);
+        return Value{raw, raw, raw == QLatin1String("null")};
+    };
+
+    // an open object or array, the document is the object
+    // around the root which isn't an element
+    struct Frame {
+        bool array;
+        bool element;
+        // the tag of the items of an array
+        QString tag;
+        bool children;
+        QString value;
+    };
+    QStack<Frame> open;
+    QString key_storage;
+    QString value_storage;
+    int i = 1;
+
+    XMLTree::ValueBuilder builder(&tree);
+
+    // the element of a member or an item at i
+    // the tag is used before anything is pushed
+    auto element = [&](QStringView tag) {
+        for(int k = open.size() - 1; k >= 0; --k) {
+            if(!open[k].array) {
+                open[k].children = true;
+                break;
+            }
+        }
+
+        const QChar c = character(i);
+        if(c == '{') {
+            builder.start_tag(tag);
+            ++i;
+            open.push({false, true, QString(), false, QString()});
+        } else if(c == '[') {
+            const Frame items = {true, false, tag.toString(), false, QString()};
+            ++i;
+            open.push(items);
         } else {
-            output << indent << group.key << ":" << space << "[" << end_line;
-            for(const auto& child : group.value) {
-                output << indent ;
-                xml2json_helper(child, spaces, depth + 1, 1, output);
+            builder.start_tag(tag);
+            const Value value = read_value(i, value_storage);
+            if(value.null) {
+                builder.self_close();
+            } else {
+                builder.close(value.value);
+                builder.end_tag();
+            }
+        }
+    };
+
+    if(size == 0)
+        return;
+    if(character(0) != '{')
+        throw error(0, "Expected {");
+
+    open.push({false, false, QString(), false, QString()});
+    while(open.size()) {
+        if(i >= size)
+            throw error(i, "Unexpected end");
+
+        // the commas between the members and the items
+        // and after the last ones are skipped
+        const QChar c = character(i);
+        if(c == ',') {
+            ++i;
+            continue;
+        }
+
+        Frame &frame = open.top();
+        if(frame.array) {
+            if(c == ']') {
+                ++i;
+                open.pop();
+            } else {
+                element(frame.tag);
             }
-            output << indent << "]," << end_line;
+            continue;
+        }
+
+        if(c == '}') {
+            ++i;
+            if(frame.element) {
+                if(!frame.children && frame.value.isEmpty()) {
+                    builder.self_close();
+                } else {
+                    builder.close(frame.value);
+                    builder.end_tag();
+                }
+            }
+            open.pop();
+            continue;
+        }
+
+        const QStringView key = read_key(i, key_storage);
+        if(key.startsWith('#') || key == QLatin1String("@text")) {
+            if(!frame.element)
+                throw error(i, "Expected an element");
+            const Value value = read_value(i, value_storage);
+            if(key.startsWith('#'))
+                builder.attribute(key.mid(1), value.raw);
+            else
+                frame.value = value.null ? QString() : value.value.toString();
+        } else {
+            element(key);
         }
     }
 
-    if(value != "")
-        output << indent << "@text:" << space << "\"" << value << "\"," << end_line;
+    if(i < size)
+        throw error(i, "Unexpected text after the document");
+}
+
+template<typename Node>
+struct JSON::HelperState
+{
+    explicit HelperState(int spaces)
+        : spaces(spaces),
+          indents(spaces),
+          space(spaces >= 0 ? " " : ""),
+          end_line(spaces >= 0 ? "\n" : "") {}
+
+    int spaces;
+    IndentTable indents;
+    QString space;
+    QString end_line;
+    // a value loaded from the source is read into it
+    QString storage;
+    GroupedWalk<Node> walk;
+};
 
-    output << indent_less << "}," << end_line;
+template<typename Node>
+QString JSON::xml2json_string(Node root, int spaces)
+{
+    return presized_text([root, spaces](auto &output) {
+        NoSplit split;
+        xml2json_root(root, spaces, output, split);
+    });
+}
+
+template<typename Node>
+QString JSON::xml2json_split(Node root, int spaces, int depth, int threads)
+{
+    if(threads <= 0)
+        threads = QThreadPool::globalInstance()->maxThreadCount();
+    if(!root || threads < 2 || depth < 1)
+        return xml2json_string(root, spaces);
+
+    // an object which is converted on its own
+    // its text goes at the offset of the skeleton
+    struct Subtree {
+        Node node;
+        int depth;
+        bool array_parent;
+        int offset;
+    };
+
+    // the skeleton is the text of the nodes above the subtrees
+    QVector<Subtree> subtrees;
+    QString skeleton;
+    QTextStream ts(&skeleton);
+    TextStreamOutput output(ts);
+    auto split = [&](Node node, int node_depth, bool array_parent) {
+        // the root is at depth 1
+        if(node_depth <= depth)
+            return false;
+        ts.flush();
+        subtrees.push_back({node, node_depth, array_parent, skeleton.size()});
+        return true;
+    };
+    xml2json_root(root, spaces, output, split);
+    ts.flush();
+
+    if(subtrees.size() < 2)
+        return xml2json_string(root, spaces);
+
+    // a chunk is the subtrees [begin, end) each after
+    // the text of the skeleton before it
+    struct Chunk {
+        int begin;
+        int end;
+        QString text;
+    };
+
+    const int n = subtrees.size();
+    const int chunks_size = qMin(n, threads * chunks_per_thread);
+    QVector<Chunk> chunks;
+    chunks.reserve(chunks_size);
+    for(int k = 0; k < chunks_size; ++k)
+        chunks.push_back({int(qint64(n) * k / chunks_size), int(qint64(n) * (k + 1) / chunks_size), QString()});
+
+    QtConcurrent::blockingMap(chunks, [&subtrees, &skeleton, spaces](Chunk &chunk) {
+        // the subtrees of the chunk share the state
+        HelperState<Node> state(spaces);
+        chunk.text = presized_text([&](auto &output) {
+            NoSplit split;
+            for(int i = chunk.begin; i < chunk.end; ++i) {
+                const Subtree &subtree = subtrees[i];
+                const int gap = i ? subtrees[i - 1].offset : 0;
+                output << QStringView(skeleton.constData() + gap, subtree.offset - gap);
+                xml2json_helper(subtree.node, subtree.depth, subtree.array_parent, state, output, split);
+            }
+        });
+    });
+
+    const int tail = subtrees.last().offset;
+    int size = skeleton.size() - tail;
+    for(const Chunk &chunk : qAsConst(chunks))
+        size += chunk.text.size();
+
+    QString builder;
+    builder.reserve(size);
+    for(const Chunk &chunk : qAsConst(chunks))
+        builder += chunk.text;
+    builder.append(skeleton.constData() + tail, skeleton.size() - tail);
+
+    return builder;
+}
+
+template<typename Node, typename Output, typename Split>
+void JSON::xml2json_root(Node root, int spaces, Output &ts, Split &split)
+{
+    QString local_indent;
+    local_indent.reserve(spaces + 2);
+    for(int i = 0; i < spaces; i++)
+        local_indent += " ";
+
+    ts << "{" << (spaces >= 0 ? "\n" : "" ) << local_indent
+       << root->tag() << ":" << (spaces >= 0 ? " " : "" );
+
+    HelperState<Node> state(spaces);
+    xml2json_helper(root, 1, 0, state, ts, split);
+
+    ts << "}";
+}
+
+template<typename Node, typename Output, typename Split>
+void JSON::xml2json_helper(Node node,
+                           int depth,
+                           bool array_parent,
+                           HelperState<Node> &state,
+                           Output &output,
+                           Split &split)
+{
+    ObjectVisitor<Node, Output, Split> visitor = {state.spaces, state.indents, state.space,
+                                                  state.end_line, state.storage, output, split};
+    state.walk.walk(node, depth, array_parent, visitor);
 }
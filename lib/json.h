@@ -2,7 +2,8 @@
 #define JSON_H
 
 #include <QString>
-#include "lib/hashmap.h"
+#include "lib/jsonscanner.h"
+#include "lib/xmldocument.h"
 #include "lib/xmltree.h"
 
 
@@ -19,19 +20,168 @@ public:
      */
     static QString xml2json(const XMLTree& tree, int spaces = -1);
 
+    /**
+     * @brief xml2json
+     *        the same for a flat document
+     * @param document
+     * @param spaces
+     * @return
+     */
+    static QString xml2json(const XMLDocument& document, int spaces = -1);
+
+    /**
+     * @brief xml2json_parallel
+     *        the same text converted on the global thread pool
+     *        the subtrees at the given depth under the root are
+     *        converted concurrently into separate strings which
+     *        are joined in order, the nodes above them are written
+     *        on the calling thread
+     *        xml2json uses it with the default depth for large trees
+     *        a lazy tree is converted on the calling thread
+     *        since reading it builds its nodes
+     * @param tree
+     * @param spaces
+     * @param depth of the subtrees, 1 is the children of the root
+     * @param threads the number of threads to split the subtrees for
+     *        0 is the size of the pool and 1 is the calling thread
+     * @complexity O(size of(tree) / threads)
+     */
+    static QString xml2json_parallel(const XMLTree& tree, int spaces = -1,
+                                     int depth = 1, int threads = 0);
+
+    /**
+     * @brief xml2json_parallel
+     *        the same for a flat document
+     */
+    static QString xml2json_parallel(const XMLDocument& document, int spaces = -1,
+                                     int depth = 1, int threads = 0);
+
+    /**
+     * @brief xml2json
+     *        write the same text to the device in UTF-8
+     *        the stream flushes its buffer to the device as it fills
+     *        so the text is never held in memory as a whole
+     * @param tree
+     * @param device an open writable device like a QFile
+     * @param spaces
+     */
+    static void xml2json(const XMLTree& tree, QIODevice *device, int spaces = -1);
+
+    /**
+     * @brief xml2json
+     *        the same for a flat document
+     * @param document
+     * @param device
+     * @param spaces
+     */
+    static void xml2json(const XMLDocument& document, QIODevice *device, int spaces = -1);
+
+    /**
+     * @brief xml2json
+     *        convert the XML read from input without building a tree
+     *        in a single pass, the nodes are written as the events
+     *        of an XMLReader come, only the first node of a run of
+     *        siblings with the same tag is held back until the next
+     *        sibling or the close of its parent tells if it's an array
+     *        so the memory is the open nodes and those first nodes
+     *        rather than the document, a sequential device works too
+     *
+     *        it's the same text as the conversion of the tree
+     *        it throws QString if the siblings with a tag aren't next
+     *        to each other or there is more than a root element
+     *        what's converted before that is left on the output
+     *        the XML must be syntactically correct
+     * @param input an open readable device, read from its position
+     * @param output an open writable device, written in UTF-8
+     * @param spaces
+     * @complexity O(length of(input))
+     */
+    static void xml2json(QIODevice *input, QIODevice *output, int spaces = -1);
+
+    /**
+     * @brief json2xml
+     *        build the tree from JSON, the inverse of xml2json
+     *        a member "#key" is an attribute whose value is kept
+     *        as it's written, "@text" is the value of the element
+     *        any other member is a child element with its key as the tag
+     *        an array is an element for each of its items
+     *        and a string or a scalar is an element with that value
+     *        "null" is an empty self closing element
+     *
+     *        the keys may be unquoted and the commas trailing
+     *        like xml2json writes them, the strings are unescaped
+     *        it throws QString if the JSON is malformed
+     * @param input
+     * @param tree replaced with the built tree
+     * @complexity O(length of(input))
+     */
+    static void json2xml(QTextStream &input, XMLTree &tree);
+
+    /**
+     * @brief json2xml
+     *        the same for UTF-8 bytes
+     */
+    static void json2xml(const QByteArray &input, XMLTree &tree);
+
 private:
+    /**
+     * @brief xml2json_string
+     *        convert a tree or a document into a string
+     *        allocated once after sizing the text
+     */
+    template<typename Node>
+    static QString xml2json_string(Node root, int spaces);
+
+    /**
+     * @brief json2xml_helper
+     *        build the tree walking the structural characters
+     */
+    static void json2xml_helper(const JSONStructuralIndex &index, XMLTree &tree);
+
+    /**
+     * @brief xml2json_split
+     *        convert the subtrees at the depth concurrently
+     *        and join them with the text of the nodes above them
+     */
+    template<typename Node>
+    static QString xml2json_split(Node root, int spaces, int depth, int threads);
+
+    /**
+     * @brief xml2json_root
+     *        write the root of a tree or a document
+     * @param output one of the outputs of textoutput.h
+     * @param split takes the nodes which are written somewhere else
+     */
+    template<typename Node, typename Output, typename Split>
+    static void xml2json_root(Node root, int spaces, Output &output, Split &split);
+
+    /**
+     * @brief The HelperState struct
+     *        the indentation, the stack and the groups of children
+     *        xml2json_helper uses, made once for all the nodes
+     *        written on a thread
+     */
+    template<typename Node>
+    struct HelperState;
+
     /**
      * @brief xml2json_helper
-     * @param node
-     * @param spaces
+     *        the children of an object are grouped by tag
+     *        the groups are written in the order their tags
+     *        first occur among the children
+     * @param node pointer to XMLNode or XMLDocument::Node
      * @param depth
+     * @param state of the same spaces for every call
      * @param output
+     * @param split
      */
-    static void xml2json_helper(const XMLNode* node,
-                                int spaces,
+    template<typename Node, typename Output, typename Split>
+    static void xml2json_helper(Node node,
                                 int depth,
                                 bool array_parent,
-                                QTextStream &output);
+                                HelperState<Node> &state,
+                                Output &output,
+                                Split &split);
 };
 
 #endif // JSON_H
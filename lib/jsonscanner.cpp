@@ -0,0 +1,220 @@
+#include "jsonscanner.h"
+
+#include <QtAlgorithms>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// the characters of a block are the bits of a 64 bit mask
+constexpr int block_size = 64;
+
+/**
+ * @brief The BlockMasks struct
+ *        the characters of a block in each class
+ *        bit i is the character i of the block
+ */
+struct BlockMasks {
+    quint64 quote;
+    quint64 backslash;
+    quint64 structural;
+    quint64 space;
+};
+
+/**
+ * @brief classify_tail
+ * @return the classes of the n < 64 characters one at a time
+ *         the bits past the end are clear
+ */
+inline BlockMasks classify_tail(const ushort *p, int n)
+{
+    BlockMasks masks = {0, 0, 0, 0};
+    for(int i = 0; i < n; ++i) {
+        const quint64 bit = quint64(1) << i;
+        switch(p[i]) {
+        case '"':
+            masks.quote |= bit;
+            break;
+        case '\\':
+            masks.backslash |= bit;
+            break;
+        case '{': case '}': case '[': case ']': case ':': case ',':
+            masks.structural |= bit;
+            break;
+        case ' ': case '\n': case '\r': case '\t':
+            masks.space |= bit;
+            break;
+        default:
+            break;
+        }
+    }
+    return masks;
+}
+
+/**
+ * @brief classify_block
+ * @return the classes of the 64 characters
+ *         "{" and "[" are 0x7B and 0x5B, "}" and "]" are 0x7D and 0x5D
+ *         so they're found with two compares of the character | 0x20
+ */
+inline BlockMasks classify_block(const ushort *p)
+{
+#if defined(__AVX2__)
+    const __m256i quote = _mm256_set1_epi16('"');
+    const __m256i backslash = _mm256_set1_epi16('\\');
+    const __m256i open = _mm256_set1_epi16('{');
+    const __m256i close = _mm256_set1_epi16('}');
+    const __m256i colon = _mm256_set1_epi16(':');
+    const __m256i comma = _mm256_set1_epi16(',');
+    const __m256i space = _mm256_set1_epi16(' ');
+    const __m256i new_line = _mm256_set1_epi16('\n');
+    const __m256i carriage = _mm256_set1_epi16('\r');
+    const __m256i tab = _mm256_set1_epi16('\t');
+    const __m256i to_brace = _mm256_set1_epi16(0x20);
+
+    // the compares of 16 bit characters are packed to bytes
+    // packs works within the 128 bit lanes, the permute orders them
+    auto mask = [](__m256i a, __m256i b) {
+        return quint64(uint(_mm256_movemask_epi8(
+                                _mm256_permute4x64_epi64(_mm256_packs_epi16(a, b), 0xD8))));
+    };
+
+    BlockMasks masks = {0, 0, 0, 0};
+    for(int i = 0; i < block_size; i += 32) {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i + 16));
+        const __m256i a_brace = _mm256_or_si256(a, to_brace);
+        const __m256i b_brace = _mm256_or_si256(b, to_brace);
+
+        masks.quote |= mask(_mm256_cmpeq_epi16(a, quote), _mm256_cmpeq_epi16(b, quote)) << i;
+        masks.backslash |= mask(_mm256_cmpeq_epi16(a, backslash), _mm256_cmpeq_epi16(b, backslash)) << i;
+        masks.structural |= mask(
+                    _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi16(a_brace, open), _mm256_cmpeq_epi16(a_brace, close)),
+                                    _mm256_or_si256(_mm256_cmpeq_epi16(a, colon), _mm256_cmpeq_epi16(a, comma))),
+                    _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi16(b_brace, open), _mm256_cmpeq_epi16(b_brace, close)),
+                                    _mm256_or_si256(_mm256_cmpeq_epi16(b, colon), _mm256_cmpeq_epi16(b, comma)))) << i;
+        masks.space |= mask(
+                    _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi16(a, space), _mm256_cmpeq_epi16(a, new_line)),
+                                    _mm256_or_si256(_mm256_cmpeq_epi16(a, carriage), _mm256_cmpeq_epi16(a, tab))),
+                    _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi16(b, space), _mm256_cmpeq_epi16(b, new_line)),
+                                    _mm256_or_si256(_mm256_cmpeq_epi16(b, carriage), _mm256_cmpeq_epi16(b, tab)))) << i;
+    }
+    return masks;
+#elif defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi16('"');
+    const __m128i backslash = _mm_set1_epi16('\\');
+    const __m128i open = _mm_set1_epi16('{');
+    const __m128i close = _mm_set1_epi16('}');
+    const __m128i colon = _mm_set1_epi16(':');
+    const __m128i comma = _mm_set1_epi16(',');
+    const __m128i space = _mm_set1_epi16(' ');
+    const __m128i new_line = _mm_set1_epi16('\n');
+    const __m128i carriage = _mm_set1_epi16('\r');
+    const __m128i tab = _mm_set1_epi16('\t');
+    const __m128i to_brace = _mm_set1_epi16(0x20);
+
+    // the compares of 16 bit characters are packed to bytes
+    auto mask = [](__m128i a, __m128i b) {
+        return quint64(uint(_mm_movemask_epi8(_mm_packs_epi16(a, b))));
+    };
+
+    BlockMasks masks = {0, 0, 0, 0};
+    for(int i = 0; i < block_size; i += 16) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i + 8));
+        const __m128i a_brace = _mm_or_si128(a, to_brace);
+        const __m128i b_brace = _mm_or_si128(b, to_brace);
+
+        masks.quote |= mask(_mm_cmpeq_epi16(a, quote), _mm_cmpeq_epi16(b, quote)) << i;
+        masks.backslash |= mask(_mm_cmpeq_epi16(a, backslash), _mm_cmpeq_epi16(b, backslash)) << i;
+        masks.structural |= mask(
+                    _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi16(a_brace, open), _mm_cmpeq_epi16(a_brace, close)),
+                                 _mm_or_si128(_mm_cmpeq_epi16(a, colon), _mm_cmpeq_epi16(a, comma))),
+                    _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi16(b_brace, open), _mm_cmpeq_epi16(b_brace, close)),
+                                 _mm_or_si128(_mm_cmpeq_epi16(b, colon), _mm_cmpeq_epi16(b, comma)))) << i;
+        masks.space |= mask(
+                    _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi16(a, space), _mm_cmpeq_epi16(a, new_line)),
+                                 _mm_or_si128(_mm_cmpeq_epi16(a, carriage), _mm_cmpeq_epi16(a, tab))),
+                    _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi16(b, space), _mm_cmpeq_epi16(b, new_line)),
+                                 _mm_or_si128(_mm_cmpeq_epi16(b, carriage), _mm_cmpeq_epi16(b, tab)))) << i;
+    }
+    return masks;
+#else
+    return classify_tail(p, block_size);
+#endif
+}
+
+/**
+ * @brief prefix_xor
+ * @return bit i is the xor of the bits up to i
+ *         the bits between two quotes are set
+ */
+inline quint64 prefix_xor(quint64 bits)
+{
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+} // namespace
+
+JSONStructuralIndex::JSONStructuralIndex(const QString &text)
+    : m_text(text),
+      m_positions()
+{
+    const ushort *p = reinterpret_cast<const ushort *>(m_text.constData());
+    const int n = m_text.size();
+    const quint64 even_bits = 0x5555555555555555ULL;
+
+    // markup of converted XML is a structural character every few
+    m_positions.reserve(n / 8 + 16);
+
+    // the state at the end of the previous block
+    // the first character is escaped, the block starts in a string
+    // the last character separates a scalar from the next one
+    quint64 prev_escaped = 0;
+    quint64 prev_in_string = 0;
+    quint64 prev_separator = 1;
+
+    for(int block = 0; block < n; block += block_size) {
+        const int size = qMin(block_size, n - block);
+        const quint64 valid = size == block_size ? ~quint64(0) : (quint64(1) << size) - 1;
+        const BlockMasks masks = size == block_size ? classify_block(p + block)
+                                                    : classify_tail(p + block, size);
+
+        // a run of backslashes escapes the character after it
+        // when its length is odd, the runs starting on odd bits
+        // are found by carrying them through the additions
+        const quint64 backslash = masks.backslash & ~prev_escaped;
+        const quint64 follows_escape = backslash << 1 | prev_escaped;
+        const quint64 odd_starts = backslash & ~even_bits & ~follows_escape;
+        const quint64 even_sequences = odd_starts + backslash;
+        prev_escaped = even_sequences < backslash;
+        const quint64 escaped = (even_bits ^ (even_sequences << 1)) & follows_escape;
+
+        // the characters from an opening quote to the closing one
+        const quint64 quote = masks.quote & ~escaped;
+        const quint64 in_string = prefix_xor(quote) ^ prev_in_string;
+        prev_in_string = quint64(qint64(in_string) >> 63);
+
+        // a scalar starts after a separator outside the strings
+        const quint64 separator = (masks.space | masks.structural) & ~in_string;
+        const quint64 scalar = ~(masks.space | masks.structural | masks.quote | in_string) &
+                               (separator << 1 | prev_separator) & valid;
+        prev_separator = separator >> 63;
+
+        quint64 bits = (masks.structural & ~in_string) | (quote & in_string) | scalar;
+        while(bits) {
+            m_positions.push_back(block + int(qCountTrailingZeroBits(bits)));
+            bits &= bits - 1;
+        }
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef JSONSCANNER_H
+#define JSONSCANNER_H
+
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief The JSONStructuralIndex class
+ *        The positions of the structural characters of a JSON text
+ *        found in a single scan of 64 characters at a time
+ *        ("{", "}", "[", "]", ":", "," outside the strings)
+ *        with the opening quote of every string and the first
+ *        character of every other scalar (numbers, true, false,
+ *        null and the unquoted values xml2json writes)
+ *
+ *        the characters of a block are classified with SIMD
+ *        compares, the escaped quotes and the insides of the
+ *        strings are masked with bit arithmetic on the block
+ *        the parser then walks the positions instead of the text
+ */
+class JSONStructuralIndex
+{
+public:
+    /**
+     * @brief JSONStructuralIndex
+     *        index the text, it's kept by the index
+     * @complexity O(length of(text))
+     */
+    explicit JSONStructuralIndex(const QString &text);
+
+    const QString &text() const { return m_text; }
+
+    /**
+     * @brief size
+     * @return number of indexed positions
+     */
+    int size() const { return m_positions.size(); }
+
+    /**
+     * @brief position
+     * @return offset in the text of the i-th indexed character
+     */
+    int position(int i) const { return m_positions[i]; }
+
+    /**
+     * @brief is_space
+     * @return true if c is JSON white space
+     */
+    static bool is_space(QChar c)
+    {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+    }
+
+private:
+    QString m_text;
+    QVector<int> m_positions;
+};
+
+#endif // JSONSCANNER_H
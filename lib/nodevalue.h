@@ -0,0 +1,123 @@
+#ifndef NODEVALUE_H
+#define NODEVALUE_H
+
+#include <QString>
+#include <QStringView>
+#include "lib/textoutput.h"
+
+/**
+ * @brief The NodeValue struct
+ *        The value of a node as the converters write it, the text
+ *        before and after its comments viewed in place
+ *        simplified, its words are separated by single spaces
+ *        the same text as removing QRegExp("<!--[\\w\\W]+-->")
+ *        and simplifying a copy of the value
+ */
+struct NodeValue
+{
+    NodeValue(QStringView value, bool simplified)
+        : before(value), after(), simplified(simplified)
+    {
+        // the greedy pattern matches from the first "<!--"
+        // to the last "-->" with at least a character between
+        int open = -1;
+        for(int i = 0; i + 3 < value.size() && open < 0; ++i)
+            if(value[i] == '<' && value[i + 1] == '!' && value[i + 2] == '-' && value[i + 3] == '-')
+                open = i;
+        if(open < 0)
+            return;
+
+        for(int i = int(value.size()) - 3; i >= open + 5; --i) {
+            if(value[i] == '-' && value[i + 1] == '-' && value[i + 2] == '>') {
+                before = value.mid(0, open);
+                after = value.mid(i + 3);
+                return;
+            }
+        }
+    }
+
+    bool is_empty() const
+    {
+        if(!simplified)
+            return before.isEmpty() && after.isEmpty();
+        for(const QStringView part : {before, after})
+            for(const QChar c : part)
+                if(!c.isSpace())
+                    return false;
+        return true;
+    }
+
+    template<typename Output>
+    void write(Output &output) const
+    {
+        if(!simplified) {
+            output << before << after;
+            return;
+        }
+
+        // a word may go on from before into after
+        bool separate = false;
+        bool word = false;
+        for(const QStringView part : {before, after}) {
+            int i = 0;
+            while(i < part.size()) {
+                if(part[i].isSpace()) {
+                    separate = separate || word;
+                    word = false;
+                    ++i;
+                    continue;
+                }
+                const int begin = i;
+                while(i < part.size() && !part[i].isSpace())
+                    ++i;
+                if(separate)
+                    output << QChar(' ');
+                output << part.mid(begin, i - begin);
+                separate = false;
+                word = true;
+            }
+        }
+    }
+
+    /**
+     * @brief text
+     * @return the written text, the value itself when
+     *         it has no comments and is already simplified
+     *         otherwise it's written into storage
+     *         which mustn't be the string the value views
+     * @complexity O(length of(value))
+     */
+    QStringView text(QString &storage) const
+    {
+        if(after.isEmpty() && (!simplified || is_simplified(before)))
+            return before;
+
+        TextSizeOutput size;
+        write(size);
+        storage.resize(size.size());
+        TextBufferOutput output(storage.data());
+        write(output);
+        return storage;
+    }
+
+    /**
+     * @brief is_simplified
+     * @return whether the text is single spaces between words
+     */
+    static bool is_simplified(QStringView text)
+    {
+        for(int i = 0; i < text.size(); ++i) {
+            if(!text[i].isSpace())
+                continue;
+            if(text[i] != ' ' || i == 0 || i + 1 == text.size() || text[i + 1].isSpace())
+                return false;
+        }
+        return true;
+    }
+
+    QStringView before;
+    QStringView after;
+    bool simplified;
+};
+
+#endif // NODEVALUE_H
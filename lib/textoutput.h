@@ -0,0 +1,105 @@
+#ifndef TEXTOUTPUT_H
+#define TEXTOUTPUT_H
+
+#include <QString>
+#include <QStringView>
+#include <QTextStream>
+
+#include <cstring>
+
+/**
+ * The outputs of the serializers
+ * they take the same text with operator <<, so a serializer
+ * can be run once with TextSizeOutput to find the exact length
+ * of its text and again with TextBufferOutput to copy it
+ * into a string allocated once
+ *
+ * nothing is kept between the passes, a serializer makes
+ * the values of the nodes again as it writes them
+ *
+ * the char strings written to them are ASCII
+ */
+
+/**
+ * @brief The TextStreamOutput class
+ *        writes to a text stream
+ */
+class TextStreamOutput
+{
+public:
+    explicit TextStreamOutput(QTextStream &stream) : m_stream(stream) {}
+
+    TextStreamOutput &operator<<(QStringView text) { m_stream << text; return *this; }
+    TextStreamOutput &operator<<(const QString &text) { m_stream << text; return *this; }
+    TextStreamOutput &operator<<(const char *text) { m_stream << text; return *this; }
+    TextStreamOutput &operator<<(QChar c) { m_stream << c; return *this; }
+
+private:
+    QTextStream &m_stream;
+};
+
+/**
+ * @brief The TextSizeOutput class
+ *        counts the characters written to it
+ */
+class TextSizeOutput
+{
+public:
+    TextSizeOutput() : m_size(0) {}
+
+    TextSizeOutput &operator<<(QStringView text) { m_size += int(text.size()); return *this; }
+    TextSizeOutput &operator<<(const QString &text) { m_size += int(text.size()); return *this; }
+    TextSizeOutput &operator<<(const char *text) { m_size += int(std::strlen(text)); return *this; }
+    TextSizeOutput &operator<<(QChar) { ++m_size; return *this; }
+
+    /**
+     * @brief size
+     * @return number of characters written
+     */
+    int size() const { return m_size; }
+
+private:
+    int m_size;
+};
+
+/**
+ * @brief The TextBufferOutput class
+ *        copies the text to a buffer which is large enough
+ */
+class TextBufferOutput
+{
+public:
+    explicit TextBufferOutput(QChar *buffer) : m_pos(buffer) {}
+
+    TextBufferOutput &operator<<(QStringView text)
+    {
+        // an empty view may have no data
+        if(text.isEmpty())
+            return *this;
+        std::memcpy(static_cast<void *>(m_pos), text.data(), size_t(text.size()) * sizeof(QChar));
+        m_pos += text.size();
+        return *this;
+    }
+
+    TextBufferOutput &operator<<(const QString &text) { return *this << QStringView(text); }
+
+    TextBufferOutput &operator<<(const char *text)
+    {
+        while(*text)
+            *m_pos++ = QChar(ushort(uchar(*text++)));
+        return *this;
+    }
+
+    TextBufferOutput &operator<<(QChar c) { *m_pos++ = c; return *this; }
+
+    /**
+     * @brief end
+     * @return the position after the last written character
+     */
+    const QChar *end() const { return m_pos; }
+
+private:
+    QChar *m_pos;
+};
+
+#endif // TEXTOUTPUT_H
@@ -0,0 +1,104 @@
+#include "xmlarena.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+XMLArena::XMLArena()
+    : m_blocks(nullptr),
+      m_pos(nullptr),
+      m_end(nullptr),
+      m_size(0)
+{
+
+}
+
+XMLArena::~XMLArena()
+{
+    clear();
+}
+
+void *XMLArena::allocate(size_t size, size_t align)
+{
+    const quintptr pos = quintptr(m_pos);
+    const quintptr aligned = (pos + align - 1) & ~quintptr(align - 1);
+
+    if(m_pos && aligned + size <= quintptr(m_end)) {
+        m_pos = reinterpret_cast<char *>(aligned + size);
+        return reinterpret_cast<void *>(aligned);
+    }
+
+    return grow(size, align);
+}
+
+char *XMLArena::grow(size_t size, size_t align)
+{
+    // large pieces get a block of their own
+    // so the rest of the current block isn't wasted
+    const size_t room = size + align + sizeof(Block);
+    const bool dedicated = room > BLOCK_SIZE / 4;
+    const size_t block_size = dedicated ? room : BLOCK_SIZE;
+
+    Block *block = static_cast<Block *>(std::malloc(block_size));
+    if(!block)
+        throw std::bad_alloc();
+    block->size = block_size;
+    m_size += block_size;
+
+    char *begin = reinterpret_cast<char *>(block + 1);
+    char *end = reinterpret_cast<char *>(block) + block_size;
+    char *start = reinterpret_cast<char *>(
+                (quintptr(begin) + align - 1) & ~quintptr(align - 1));
+
+    if(dedicated && m_blocks) {
+        // keep bumping in the current block
+        block->next = m_blocks->next;
+        m_blocks->next = block;
+    } else {
+        block->next = m_blocks;
+        m_blocks = block;
+        m_pos = start + size;
+        m_end = end;
+    }
+
+    return start;
+}
+
+QStringView XMLArena::copy(QStringView text)
+{
+    if(text.isEmpty())
+        return QStringView();
+
+    QChar *data = static_cast<QChar *>(allocate(text.size() * sizeof(QChar), alignof(QChar)));
+    std::memcpy(data, text.data(), text.size() * sizeof(QChar));
+    return QStringView(data, text.size());
+}
+
+QStringView XMLArena::copy(std::string_view text)
+{
+    if(text.empty())
+        return QStringView();
+
+    // ASCII is widened in place, anything else is decoded first
+    for(const char c : text)
+        if(uchar(c) >= 0x80)
+            return copy(QStringView(QString::fromUtf8(text.data(), int(text.size()))));
+
+    QChar *data = static_cast<QChar *>(allocate(text.size() * sizeof(QChar), alignof(QChar)));
+    for(size_t i = 0; i < text.size(); ++i)
+        data[i] = QChar(ushort(uchar(text[i])));
+    return QStringView(data, int(text.size()));
+}
+
+void XMLArena::clear()
+{
+    while(m_blocks) {
+        Block *next = m_blocks->next;
+        std::free(m_blocks);
+        m_blocks = next;
+    }
+
+    m_pos = nullptr;
+    m_end = nullptr;
+    m_size = 0;
+}
@@ -0,0 +1,96 @@
+#ifndef XMLARENA_H
+#define XMLARENA_H
+
+#include <QString>
+#include <QStringView>
+#include <QtGlobal>
+
+#include <cstddef>
+#include <string_view>
+
+/**
+ * @brief The XMLArena class
+ *        Bump allocator for the nodes of a tree and their text
+ *        it hands out pieces of large blocks which are never
+ *        freed one by one, all of them are released at once
+ *        when the arena is cleared or destroyed
+ *
+ *        nothing placed in it is destroyed, so it only holds
+ *        trivially destructible objects and text
+ */
+class XMLArena
+{
+public:
+    /**
+     * @brief XMLArena
+     *        Default constructor
+     *        it allocates nothing until the first allocation
+     */
+    XMLArena();
+
+    /**
+      * Destructor
+      */
+    ~XMLArena();
+
+    Q_DISABLE_COPY(XMLArena)
+
+    /**
+     * @brief allocate
+     * @return uninitialized memory of the given size and alignment
+     *         valid until the arena is cleared
+     * @complexity amortized O(1)
+     */
+    void *allocate(size_t size, size_t align = alignof(std::max_align_t));
+
+    /**
+     * @brief copy
+     * @return view of a copy of the text in the arena
+     * @complexity O(length of(text))
+     */
+    QStringView copy(QStringView text);
+
+    /**
+     * @brief copy
+     * @return view of the UTF-16 decoding of the UTF-8 text
+     *         copied in the arena
+     * @complexity O(length of(text))
+     */
+    QStringView copy(std::string_view text);
+
+    /**
+     * @brief clear
+     *        release all the blocks
+     * @complexity O(number of blocks)
+     */
+    void clear();
+
+    /**
+     * @brief size
+     * @return number of bytes in the allocated blocks
+     */
+    size_t size() const { return m_size; }
+
+private:
+    struct Block {
+        Block *next;
+        size_t size;
+    };
+
+    /**
+     * @brief grow
+     *        allocate a block with room for at least
+     *        the given size and alignment
+     * @return the aligned start of the room
+     */
+    char *grow(size_t size, size_t align);
+
+    Block *m_blocks;
+    char *m_pos;
+    char *m_end;
+    size_t m_size;
+
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+};
+
+#endif // XMLARENA_H
@@ -0,0 +1,298 @@
+#include "xmldocument.h"
+#include "dumplayout.h"
+#include "textoutput.h"
+#include "xmltree.h"
+
+XMLDocument::XMLDocument()
+    : m_parent(),
+      m_first_child(),
+      m_next_sibling(),
+      m_children_size(),
+      m_tag(),
+      m_value(),
+      m_selfclosing(),
+      m_attributes_begin(),
+      m_attributes_end(),
+      m_attributes(),
+      m_text(),
+      m_names(),
+      m_size(0)
+{
+
+}
+
+QString XMLDocument::dump(int spaces) const
+{
+    // size the text first to allocate it at once
+    TextSizeOutput sizes;
+    dump_stream(spaces, sizes);
+
+    QString builder;
+    builder.resize(sizes.size());
+    TextBufferOutput output(builder.data());
+    dump_stream(spaces, output);
+    Q_ASSERT(output.end() == builder.constData() + builder.size());
+
+    return builder;
+}
+
+void XMLDocument::dump(QIODevice *device, int spaces) const
+{
+    QTextStream ts(device);
+    ts.setCodec("UTF-8");
+
+    TextStreamOutput output(ts);
+    dump_stream(spaces, output);
+    ts.flush();
+}
+
+template<typename Output>
+void XMLDocument::dump_stream(int spaces, Output &output) const
+{
+    if(spaces < 0) {
+        MinifiedLayout layout;
+        dump_helper(layout, output);
+    } else {
+        IndentedLayout layout(spaces, ' ');
+        dump_helper(layout, output);
+    }
+}
+
+template<typename Layout, typename Output>
+void XMLDocument::dump_helper(Layout &layout, Output &output) const
+{
+    const int n = m_parent.size();
+    if(n == 0)
+        return;
+
+    // the open nodes are the ancestors of the current one
+    QStack<int> open;
+    auto close = [&]() {
+        const int node = open.pop();
+        layout.indent(output, open.size());
+        output << "</" << m_names.name(m_tag[node]) << ">";
+        layout.end_line(output);
+    };
+
+    // the nodes are in document order
+    for(int node = 0; node < n; ++node) {
+        while(open.size() && open.top() != m_parent[node])
+            close();
+
+        layout.indent(output, open.size());
+        output << "<" << m_names.name(m_tag[node]);
+
+        for(int i = m_attributes_begin[node]; i < m_attributes_end[node]; ++i)
+            output << " " << m_names.name(m_attributes[i].key) << "=" << text(m_attributes[i].value);
+
+        if(m_selfclosing[node]) {
+            output << "/>";
+            layout.end_line(output);
+            continue;
+        }
+
+        output << ">";
+        layout.end_line(output);
+        layout.write_value(output, text(m_value[node]), open.size() + 1);
+
+        open.push(node);
+    }
+
+    while(open.size())
+        close();
+}
+
+void XMLDocument::load(QTextStream &input)
+{
+    load_tokens(XMLTokenList(input.readAll()));
+}
+
+void XMLDocument::load(const QByteArray &input)
+{
+    load_tokens(XMLUtf8TokenList(input));
+}
+
+template<typename Encoding>
+void XMLDocument::load_tokens(const XMLBasicTokenList<Encoding> &list)
+{
+    clear();
+
+    // every node starts with a "<", reserve the arrays once
+    int opens = 1;
+    for(int i = 0; i < list.size(); ++i)
+        opens += list.kind(i) == XMLToken::Open;
+    reserve(opens);
+
+    Builder builder(this);
+    XMLTree::SyntaxSummary<Encoding> summary;
+    XMLTree::parse_helper(list, 0, list.size(), &builder, summary);
+
+    m_text.squeeze();
+}
+
+void XMLDocument::clear()
+{
+    m_parent.clear();
+    m_first_child.clear();
+    m_next_sibling.clear();
+    m_children_size.clear();
+    m_tag.clear();
+    m_value.clear();
+    m_selfclosing.clear();
+    m_attributes_begin.clear();
+    m_attributes_end.clear();
+    m_attributes.clear();
+    m_text.clear();
+    m_names.clear();
+    m_size = 0;
+}
+
+void XMLDocument::reserve(int nodes)
+{
+    m_parent.reserve(nodes);
+    m_first_child.reserve(nodes);
+    m_next_sibling.reserve(nodes);
+    m_children_size.reserve(nodes);
+    m_tag.reserve(nodes);
+    m_value.reserve(nodes);
+    m_selfclosing.reserve(nodes);
+    m_attributes_begin.reserve(nodes);
+    m_attributes_end.reserve(nodes);
+}
+
+size_t XMLDocument::memory_size() const
+{
+    const size_t nodes = size_t(m_parent.capacity()) * sizeof(int) * 7 +
+                         size_t(m_value.capacity()) * sizeof(Span) +
+                         size_t(m_selfclosing.capacity()) * sizeof(uchar);
+    return nodes +
+           size_t(m_attributes.capacity()) * sizeof(Attribute) +
+           size_t(m_text.capacity()) * sizeof(QChar);
+}
+
+XMLDocument::Span XMLDocument::append_text(QStringView text)
+{
+    const Span span = {m_text.size(), int(text.size())};
+    m_text.append(text.data(), int(text.size()));
+    return span;
+}
+
+XMLDocument::Span XMLDocument::append_text(std::string_view text)
+{
+    return append_text(QStringView(QString::fromUtf8(text.data(), int(text.size()))));
+}
+
+QList<MPair<QString, QString>> XMLDocument::attributes(int node) const
+{
+    QList<MPair<QString, QString>> attributes;
+    attributes.reserve(attributes_size(node));
+    for(int i = 0; i < attributes_size(node); ++i)
+        attributes.append(MPair<QString, QString>(attribute_key(node, i), attribute_value(node, i)));
+    return attributes;
+}
+
+QList<XMLDocument::Node> XMLDocument::children(int node) const
+{
+    QList<Node> children;
+    children.reserve(m_children_size[node]);
+    for(int child = m_first_child[node]; child >= 0; child = m_next_sibling[child])
+        children.append(Node(this, child));
+    return children;
+}
+
+XMLDocument::Builder::Builder(XMLDocument *document)
+    : m_document(document),
+      m_nodes(),
+      m_last_child()
+{
+    // the root exists even for an empty document
+    add_node(-1);
+}
+
+int XMLDocument::Builder::add_node(int parent)
+{
+    XMLDocument *d = m_document;
+    const int node = d->m_parent.size();
+
+    d->m_parent.push_back(parent);
+    d->m_first_child.push_back(-1);
+    d->m_next_sibling.push_back(-1);
+    d->m_children_size.push_back(0);
+    d->m_tag.push_back(0);
+    d->m_value.push_back({0, 0});
+    d->m_selfclosing.push_back(0);
+    d->m_attributes_begin.push_back(d->m_attributes.size());
+    d->m_attributes_end.push_back(d->m_attributes.size());
+    m_last_child.push_back(-1);
+
+    if(parent >= 0) {
+        if(m_last_child[parent] >= 0)
+            d->m_next_sibling[m_last_child[parent]] = node;
+        else
+            d->m_first_child[parent] = node;
+        m_last_child[parent] = node;
+        ++d->m_children_size[parent];
+    }
+
+    return node;
+}
+
+template<typename View>
+void XMLDocument::Builder::start_tag(View tag)
+{
+    // the nodes after the root are added as its children
+    // unless the root has none, then they replace it
+    int parent = m_nodes.size() ? m_nodes.top() : -1;
+    if(parent < 0 && !m_document->is_leaf(0))
+        parent = 0;
+
+    const int node = parent >= 0 ? add_node(parent) : 0;
+    m_document->m_tag[node] = m_document->m_names.intern(tag);
+    m_nodes.push(node);
+}
+
+template<typename View>
+void XMLDocument::Builder::attribute(View key, View value)
+{
+    // the attributes of the last started node are at the end
+    // the root only starts again while it's the only node
+    XMLDocument *d = m_document;
+    const int node = m_nodes.top();
+    const Attribute attribute = {d->m_names.intern(key), d->append_text(value)};
+
+    for(int i = d->m_attributes_begin[node]; i < d->m_attributes_end[node]; ++i) {
+        if(d->m_attributes[i].key == attribute.key) {
+            d->m_attributes[i].value = attribute.value;
+            return;
+        }
+    }
+    d->m_attributes.push_back(attribute);
+    ++d->m_attributes_end[node];
+}
+
+void XMLDocument::Builder::self_close()
+{
+    m_document->m_selfclosing[m_nodes.pop()] = 1;
+    ++m_document->m_size;
+}
+
+template<typename View>
+void XMLDocument::Builder::close(View raw)
+{
+    const int node = m_nodes.top();
+    m_document->m_selfclosing[node] = 0;
+    m_document->m_value[node] = m_document->append_text(QStringView(XMLTree::value_text(raw)));
+    ++m_document->m_size;
+}
+
+void XMLDocument::Builder::end_tag()
+{
+    m_nodes.pop();
+}
+
+template void XMLDocument::Builder::start_tag(QStringView);
+template void XMLDocument::Builder::start_tag(std::string_view);
+template void XMLDocument::Builder::attribute(QStringView, QStringView);
+template void XMLDocument::Builder::attribute(std::string_view, std::string_view);
+template void XMLDocument::Builder::close(QStringView);
+template void XMLDocument::Builder::close(std::string_view);
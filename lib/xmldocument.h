@@ -0,0 +1,313 @@
+#ifndef XMLDOCUMENT_H
+#define XMLDOCUMENT_H
+
+#include <QList>
+#include <QStack>
+#include <QString>
+#include <QStringView>
+#include <QTextStream>
+#include <QVector>
+
+#include "lib/mpair.h"
+#include "lib/xmlscanner.h"
+#include "lib/xmlsymbols.h"
+
+/**
+ * @brief The XMLDocument class
+ *        Flat alternative to XMLTree for large documents
+ *        the nodes are indices in document order and every
+ *        property of them is kept in its own array
+ *        (parent, first child, next sibling, tag, value, attributes)
+ *        so the document is a few large allocations instead
+ *        of an object per node and walking it scans the arrays
+ *        sequentially
+ *
+ *        it's loaded the same way as XMLTree and holds
+ *        the same nodes, the node at index 0 is the root
+ */
+class XMLDocument
+{
+public:
+    /**
+     * @brief The Node class
+     *        Handle of a node of the document
+     *        it has the reading API of XMLNode
+     *        a null handle is false
+     */
+    class Node
+    {
+    public:
+        Node() : m_document(nullptr), m_index(-1) {}
+        Node(const XMLDocument *document, int index)
+            : m_document(document), m_index(document ? index : -1) {}
+
+        explicit operator bool() const { return m_index >= 0; }
+        bool operator==(const Node &node) const { return m_index == node.m_index; }
+        bool operator!=(const Node &node) const { return m_index != node.m_index; }
+
+        /**
+         * @brief operator ->
+         *        lets the handle be used like an XMLNode pointer
+         */
+        const Node *operator->() const { return this; }
+
+        /**
+         * @brief index
+         * @return index of the node in the document
+         */
+        int index() const { return m_index; }
+
+        QString tag() const { return m_document->tag(m_index); }
+        int tag_id() const { return m_document->tag_id(m_index); }
+        QString value() const { return m_document->value(m_index); }
+        QStringView value(QString &) const { return m_document->value_view(m_index); }
+        int children_size() const { return m_document->children_size(m_index); }
+        int attributes_size() const { return m_document->attributes_size(m_index); }
+        bool is_leaf() const { return m_document->is_leaf(m_index); }
+        bool is_selfclosing() const { return m_document->is_selfclosing(m_index); }
+        QString attribute_key(int i) const { return m_document->attribute_key(m_index, i); }
+        QString attribute_value(int i) const { return m_document->attribute_value(m_index, i); }
+        QList<MPair<QString, QString>> attributes() const { return m_document->attributes(m_index); }
+        QList<Node> children() const { return m_document->children(m_index); }
+        Node parent() const { return Node(m_document, m_document->parent(m_index)); }
+        Node first_child() const { return Node(m_document, m_document->first_child(m_index)); }
+        Node next_sibling() const { return Node(m_document, m_document->next_sibling(m_index)); }
+
+    private:
+        const XMLDocument *m_document;
+        int m_index;
+    };
+
+    /**
+     * @brief The Builder class
+     *        appends the nodes found by the loader
+     */
+    class Builder;
+
+    /**
+     * @brief XMLDocument
+     *        Default constructor
+     */
+    XMLDocument();
+
+    /**
+     * @brief dump
+     * @return the same text as XMLTree::dump
+     *         it's written in a single scan of the nodes
+     * @complexity O(sizeof(document))
+     */
+    QString dump(int spaces = -1) const;
+
+    /**
+     * @brief dump
+     *        write the same text to the device in UTF-8
+     *        as the stream's buffer fills
+     * @complexity O(sizeof(document))
+     */
+    void dump(QIODevice *device, int spaces = -1) const;
+
+    /**
+     * @brief load
+     *        load the document from input stream
+     *        The XML must be syntactically correct
+     * @complexity O(length of(input))
+     */
+    void load(QTextStream& input);
+
+    /**
+     * @brief load
+     *        load the document from UTF-8 bytes
+     *        The XML must be syntactically correct
+     * @complexity O(length of(input))
+     */
+    void load(const QByteArray& input);
+
+    /**
+     * @brief size
+     * @return number of XML Nodes the same as XMLTree::size
+     */
+    int size() const { return m_size; }
+
+    /**
+     * @brief nodes
+     * @return number of node indices
+     */
+    int nodes() const { return m_parent.size(); }
+
+    /**
+     * @brief root
+     * @return the root node or a null handle
+     *         if nothing is loaded
+     */
+    Node root() const { return Node(this, m_parent.size() ? 0 : -1); }
+
+    /**
+     * @brief memory_size
+     * @return number of bytes held by the arrays of the document
+     *         for its nodes, their attributes and values
+     */
+    size_t memory_size() const;
+
+    int parent(int node) const { return m_parent[node]; }
+    int first_child(int node) const { return m_first_child[node]; }
+    int next_sibling(int node) const { return m_next_sibling[node]; }
+    int tag_id(int node) const { return m_tag[node]; }
+    QString tag(int node) const { return m_names.name(m_tag[node]); }
+    QString value(int node) const { return text(m_value[node]).toString(); }
+
+    /**
+     * @brief value_view
+     * @return view of the value in the text pool
+     */
+    QStringView value_view(int node) const { return text(m_value[node]); }
+
+    int children_size(int node) const { return m_children_size[node]; }
+    bool is_leaf(int node) const { return m_first_child[node] < 0; }
+    bool is_selfclosing(int node) const { return m_selfclosing[node] != 0; }
+
+    int attributes_size(int node) const
+    {
+        return m_attributes_end[node] - m_attributes_begin[node];
+    }
+
+    QString attribute_key(int node, int i) const
+    {
+        return m_names.name(m_attributes[m_attributes_begin[node] + i].key);
+    }
+
+    QString attribute_value(int node, int i) const
+    {
+        return text(m_attributes[m_attributes_begin[node] + i].value).toString();
+    }
+
+    /**
+     * @brief attributes
+     * @return the attributes of the node in document order
+     */
+    QList<MPair<QString, QString>> attributes(int node) const;
+
+    /**
+     * @brief children
+     * @return handles of the children of the node
+     */
+    QList<Node> children(int node) const;
+
+private:
+    /**
+     * @brief The Span struct
+     *        characters of the text pool
+     */
+    struct Span {
+        int offset;
+        int length;
+    };
+
+    struct Attribute {
+        int key;
+        Span value;
+    };
+
+    /**
+     * @brief dump_stream
+     *        dump the nodes into output with the layout
+     *        of the number of spaces
+     * @param output one of the outputs of textoutput.h
+     */
+    template<typename Output>
+    void dump_stream(int spaces, Output &output) const;
+
+    /**
+     * @brief dump_helper
+     *        write the nodes to the output
+     *        it's instantiated for every layout like XMLTree::dump_helper
+     */
+    template<typename Layout, typename Output>
+    void dump_helper(Layout &layout, Output &output) const;
+
+    /**
+     * @brief load_tokens
+     *        replace the document with the one built from the tokens
+     */
+    template<typename Encoding>
+    void load_tokens(const XMLBasicTokenList<Encoding> &list);
+
+    /**
+     * @brief clear
+     *        remove all the nodes
+     */
+    void clear();
+
+    /**
+     * @brief reserve
+     *        allocate the arrays of the nodes at once
+     */
+    void reserve(int nodes);
+
+    /**
+     * @brief append_text
+     * @return span of a copy of the text in the pool
+     */
+    Span append_text(QStringView text);
+    Span append_text(std::string_view text);
+
+    /**
+     * @brief text
+     * @return view of the span
+     */
+    QStringView text(const Span &span) const
+    {
+        return QStringView(m_text.constData() + span.offset, span.length);
+    }
+
+    // the properties of the nodes by index
+    QVector<int> m_parent;
+    QVector<int> m_first_child;
+    QVector<int> m_next_sibling;
+    QVector<int> m_children_size;
+    QVector<int> m_tag;
+    QVector<Span> m_value;
+    QVector<uchar> m_selfclosing;
+    // the attributes of a node are the range [begin, end)
+    QVector<int> m_attributes_begin;
+    QVector<int> m_attributes_end;
+
+    QVector<Attribute> m_attributes;
+    // the values of the nodes and the attributes
+    QString m_text;
+    XMLSymbolTable m_names;
+    int m_size;
+};
+
+class XMLDocument::Builder
+{
+public:
+    explicit Builder(XMLDocument *document);
+
+    template<typename View>
+    void start_tag(View tag);
+
+    template<typename View>
+    void attribute(View key, View value);
+
+    void self_close();
+
+    template<typename View>
+    void close(View raw);
+
+    void end_tag();
+
+private:
+    /**
+     * @brief add_node
+     * @return index of a new node appended as the last child of parent
+     */
+    int add_node(int parent);
+
+    XMLDocument *m_document;
+    // the open nodes, it follows the stack of tags
+    QStack<int> m_nodes;
+    // the last children are only needed while building
+    QVector<int> m_last_child;
+};
+
+#endif // XMLDOCUMENT_H
@@ -0,0 +1,75 @@
+#include "xmlformatter.h"
+#include "dumplayout.h"
+#include "textoutput.h"
+#include "xmlreader.h"
+
+#include <QTextStream>
+
+void XMLFormatter::format(QIODevice *input, QIODevice *output, int spaces)
+{
+    if(spaces < 0) {
+        MinifiedLayout layout;
+        format_helper(input, output, layout);
+    } else {
+        IndentedLayout layout(spaces, ' ');
+        format_helper(input, output, layout);
+    }
+}
+
+template<typename Layout>
+void XMLFormatter::format_helper(QIODevice *input, QIODevice *output, Layout &layout)
+{
+    XMLReader reader(input);
+    QTextStream ts(output);
+    ts.setCodec("UTF-8");
+    TextStreamOutput out(ts);
+
+    // the start tag is left open until the next event
+    // a self closing node ends it with "/>"
+    bool in_tag = false;
+    auto close_tag = [&]() {
+        if(in_tag) {
+            out << ">";
+            layout.end_line(out);
+        }
+        in_tag = false;
+    };
+
+    while(reader.next() != XMLReader::EndDocument) {
+        switch(reader.event()) {
+        case XMLReader::StartElement:
+            close_tag();
+            layout.indent(out, reader.depth() - 1);
+            out << "<" << reader.name();
+            in_tag = true;
+            break;
+
+        case XMLReader::Attribute:
+            out << " " << reader.name() << "=" << reader.value();
+            break;
+
+        case XMLReader::Text:
+            close_tag();
+            layout.write_value(out, reader.value(), reader.depth());
+            break;
+
+        case XMLReader::EndElement:
+            if(reader.is_selfclosing()) {
+                out << "/>";
+                layout.end_line(out);
+                in_tag = false;
+                break;
+            }
+            close_tag();
+            layout.indent(out, reader.depth());
+            out << "</" << reader.name() << ">";
+            layout.end_line(out);
+            break;
+
+        case XMLReader::EndDocument:
+            break;
+        }
+    }
+
+    ts.flush();
+}
@@ -0,0 +1,43 @@
+#ifndef XMLFORMATTER_H
+#define XMLFORMATTER_H
+
+#include <QIODevice>
+
+/**
+ * @brief The XMLFormatter class
+ *        Minify or prettify XML without building a tree
+ *        it follows the events of an XMLReader and writes
+ *        every node as soon as the event after its attributes
+ *        tells whether it's self closing, so its memory is
+ *        the buffers of the reader and the output stream
+ *        and the tags of the open nodes
+ *
+ *        the output is the same as XMLTree::dump for
+ *        a document with a single root element
+ *        the XML must be syntactically correct
+ */
+class XMLFormatter
+{
+public:
+    /**
+     * @brief format
+     *        write the XML read from input to output in UTF-8
+     *        with the indentation of XMLTree::dump
+     * @param input an open readable device
+     * @param output an open writable device
+     * @param spaces indentation size, negative value means minifying
+     * @complexity O(length of(input))
+     */
+    static void format(QIODevice *input, QIODevice *output, int spaces = -1);
+
+private:
+    /**
+     * @brief format_helper
+     *        it's instantiated for every layout of dumplayout.h
+     *        like XMLTree::dump_helper so they write the same text
+     */
+    template<typename Layout>
+    static void format_helper(QIODevice *input, QIODevice *output, Layout &layout);
+};
+
+#endif // XMLFORMATTER_H
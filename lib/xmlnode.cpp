@@ -1,36 +1,51 @@
 #include "xmlnode.h"
+#include "xmltree.h"
 
-XMLNode::XMLNode()
-    : m_tag(""),
-      m_value(""),
+#include <algorithm>
+
+XMLNode::XMLNode(XMLTree *tree)
+    : m_tree(tree),
+      m_tag(0),
+      m_value(),
+      m_source_offset(0),
+      m_source_size(0),
       m_parent(nullptr),
+      m_first_child(nullptr),
+      m_last_child(nullptr),
+      m_next_sibling(nullptr),
+      m_children_size(0),
+      m_lazy(-1),
       m_selfclosing(false),
-      m_children(),
-      m_attributes()
+      m_attributes_size(0),
+      m_attributes_capacity(INLINE_ATTRIBUTES),
+      m_attributes(m_inline)
 {
 
 }
 
-XMLNode::~XMLNode()
-{
-    for(auto& child : m_children) {
-        delete child;
-        child = nullptr;
-    }
-}
-
 QString XMLNode::tag() const
 {
-    return m_tag;
+    return m_tree->m_names.name(m_tag);
 }
 
 void XMLNode::set_tag(const QString &tag)
 {
-    m_tag = tag;
+    m_tag = m_tree->m_names.intern(QStringView(tag));
 }
 
 QString XMLNode::value() const
 {
+    if(m_source_size)
+        return m_tree->source_value(m_source_offset, m_source_size);
+    return m_value.toString();
+}
+
+QStringView XMLNode::value(QString &storage) const
+{
+    if(m_source_size) {
+        storage = m_tree->source_value(m_source_offset, m_source_size);
+        return storage;
+    }
     return m_value;
 }
 
@@ -38,29 +53,43 @@ void XMLNode::set_value(const QString &value)
 {
     if(m_selfclosing)
         throw QString("Can't set value in self closing node");
-    m_value = value;
+    m_value = m_tree->m_arena.copy(value);
+    m_source_size = 0;
 }
 
 void XMLNode::add_child(XMLNode *node)
 {
     if(m_selfclosing)
         throw QString("Can't add child in self closing node");
-    m_children.append(node);
+
+    // the new child goes after the ones in the source
+    if(m_lazy >= 0)
+        expand();
+
+    if(m_last_child)
+        m_last_child->m_next_sibling = node;
+    else
+        m_first_child = node;
+    m_last_child = node;
+    ++m_children_size;
 }
 
 int XMLNode::children_size() const
 {
-    return m_children.size();
+    if(m_lazy >= 0)
+        expand();
+    return m_children_size;
 }
 
 int XMLNode::attributes_size() const
 {
-    return m_attributes.size();
+    return m_attributes_size;
 }
 
 bool XMLNode::is_leaf() const
 {
-    return children_size() == 0;
+    // a lazy node has children in the source
+    return m_lazy < 0 && m_children_size == 0;
 }
 
 bool XMLNode::is_selfclosing() const
@@ -70,26 +99,70 @@ bool XMLNode::is_selfclosing() const
 
 void XMLNode::add_attribute(const QString &key, const QString &value)
 {
-    m_attributes.insert(key, value);
+    set_attribute({m_tree->m_names.intern(QStringView(key)),
+                   m_tree->m_arena.copy(QStringView(value))});
+}
+
+void XMLNode::expand() const
+{
+    m_tree->expand(const_cast<XMLNode *>(this));
+}
+
+void XMLNode::set_attribute(const XMLAttribute &attribute)
+{
+    for(int i = 0; i < m_attributes_size; ++i) {
+        if(m_attributes[i].key == attribute.key) {
+            m_attributes[i].value = attribute.value;
+            return;
+        }
+    }
+
+    if(m_attributes_size == m_attributes_capacity) {
+        // the old array is left in the arena
+        const int capacity = m_attributes_capacity * 2;
+        XMLAttribute *attributes = static_cast<XMLAttribute *>(
+                    m_tree->m_arena.allocate(capacity * sizeof(XMLAttribute), alignof(XMLAttribute)));
+        std::copy(m_attributes, m_attributes + m_attributes_size, attributes);
+        m_attributes = attributes;
+        m_attributes_capacity = capacity;
+    }
+    m_attributes[m_attributes_size++] = attribute;
 }
 
 void XMLNode::add_attribute(const MPair<QString, QString> &attribute)
 {
-    m_attributes.insert(attribute);
+    add_attribute(attribute.key, attribute.value);
 }
 
 QList<XMLNode *> XMLNode::children() const
 {
-    return m_children;
+    QList<XMLNode *> children;
+    children.reserve(children_size());
+    for(XMLNode *child = m_first_child; child; child = child->m_next_sibling)
+        children.append(child);
+    return children;
 }
 
-HashMap<QString, QString> XMLNode::attributes() const
+QList<MPair<QString, QString>> XMLNode::attributes() const
 {
-    return m_attributes;
+    QList<MPair<QString, QString>> attributes;
+    attributes.reserve(m_attributes_size);
+    for(int i = 0; i < m_attributes_size; ++i)
+        attributes.append(MPair<QString, QString>(attribute_key(i), attribute_value(i)));
+    return attributes;
+}
+
+QString XMLNode::attribute_key(int i) const
+{
+    return m_tree->m_names.name(m_attributes[i].key);
+}
+
+QString XMLNode::attribute_value(int i) const
+{
+    return m_attributes[i].value.toString();
 }
 
 XMLNode *XMLNode::parent() const
 {
     return m_parent;
 }
-
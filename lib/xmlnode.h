@@ -3,26 +3,36 @@
 
 #include <QList>
 #include <QString>
+#include <QStringView>
+
+#include "mpair.h"
+
+class XMLTree;
+
+/**
+ * @brief The XMLAttribute struct
+ *        An attribute of a node
+ *        the id of its interned key and a span of its value
+ *        in the arena of the tree
+ */
+struct XMLAttribute
+{
+    int key;
+    QStringView value;
+};
 
-#include "hashmap.h"
 /**
  * @brief The XMLNode class
  *        Represents a node in XML Tree
+ *        the nodes and their text are allocated in the arena
+ *        of their tree and live as long as the tree
+ *        the children are linked through their next sibling
+ *        the children of a node of a lazy tree are built
+ *        when they are first requested
  */
 class XMLNode
 {
 public:
-    /**
-     * @brief XMLNode
-     *        Default constructor
-     */
-    XMLNode();
-
-    /**
-      * Destructor
-      */
-    ~XMLNode();
-
     /**
      * @brief tag
      * @return tag name
@@ -35,12 +45,30 @@ public:
      */
     void set_tag(const QString &tag);
 
+    /**
+     * @brief tag_id
+     * @return id of the tag name in the symbol table of the tree
+     *         nodes of the same tree with equal tags have equal ids
+     */
+    int tag_id() const { return m_tag; }
+
     /**
      * @brief value
      * @return value
+     *         a loaded value is read from the source of the tree
+     *         every time it's requested, it isn't stored
+     * @complexity O(length of(value))
      */
     QString value() const;
 
+    /**
+     * @brief value
+     * @return view of the value, a set value is viewed in the arena
+     *         and a loaded one is read into storage first
+     *         so reading set values allocates nothing
+     */
+    QStringView value(QString &storage) const;
+
     /**
      * @brief set_value
      *        update the value of the node
@@ -49,9 +77,28 @@ public:
 
     /**
      * @brief add_child
+     *        append a node of the same tree to the children
      */
     void add_child(XMLNode* node);
 
+    /**
+     * @brief first_child
+     * @return pointer to the first child or nullptr
+     *         the children of a lazy node are built first
+     */
+    XMLNode *first_child() const
+    {
+        if(m_lazy >= 0)
+            expand();
+        return m_first_child;
+    }
+
+    /**
+     * @brief next_sibling
+     * @return pointer to the next child of the parent or nullptr
+     */
+    XMLNode *next_sibling() const { return m_next_sibling; }
+
     /**
      * @brief children_size
      * @return number of children
@@ -79,6 +126,9 @@ public:
     /**
      * @brief add_attribute
      *        add attribute in form of key/value pair
+     *        after the other attributes
+     *        the value of an existing key is replaced in place
+     * @complexity O(number of attributes)
      */
     void add_attribute(const QString &key, const QString &value);
 
@@ -91,14 +141,28 @@ public:
     /**
      * @brief children
      * @return QList of pointers to the children of this node
+     * @complexity O(number of children)
      */
     QList<XMLNode *> children() const;
 
     /**
      * @brief attributes
-     * @return the attributes of this node
+     * @return the attributes of this node in document order
+     * @complexity O(number of attributes)
+     */
+    QList<MPair<QString, QString>> attributes() const;
+
+    /**
+     * @brief attribute_key
+     * @return the key of the attribute at index i
+     */
+    QString attribute_key(int i) const;
+
+    /**
+     * @brief attribute_value
+     * @return the value of the attribute at index i
      */
-    HashMap<QString, QString> attributes() const;
+    QString attribute_value(int i) const;
 
     /**
      * @brief parent
@@ -109,12 +173,59 @@ public:
     friend class XMLTree;
 
 private:
-    QString m_tag;
-    QString m_value;
+    /**
+     * @brief XMLNode
+     *        construct a node in the arena of the tree
+     *        only the tree creates nodes
+     */
+    explicit XMLNode(XMLTree *tree);
+
+    /**
+      * Destructor
+      * the nodes are released with the arena of their tree
+      */
+    ~XMLNode() = default;
+
+    /**
+     * @brief expand
+     *        build the children of a lazy node
+     */
+    void expand() const;
+
+    /**
+     * @brief set_attribute
+     *        replace the value of the attribute with the same key
+     *        or add the attribute after the others
+     *        spilling the attributes to the arena when
+     *        they don't fit in the node
+     * @complexity O(number of attributes)
+     */
+    void set_attribute(const XMLAttribute &attribute);
+
+    // most nodes have a few attributes, they are kept in the node
+    static constexpr int INLINE_ATTRIBUTES = 2;
+
+    XMLTree * m_tree;
+    int m_tag;
+    // a set value is in the arena, a loaded one is the raw
+    // text at an offset of the source of the tree
+    QStringView m_value;
+    int m_source_offset;
+    int m_source_size;
     XMLNode * m_parent;
+    XMLNode * m_first_child;
+    XMLNode * m_last_child;
+    XMLNode * m_next_sibling;
+    int m_children_size;
+    // the skip index entry of a lazily loaded node
+    // until its children are built then -1
+    int m_lazy;
     bool m_selfclosing;
-    QList<XMLNode *> m_children;
-    HashMap<QString, QString> m_attributes;
+    int m_attributes_size;
+    int m_attributes_capacity;
+    // points to m_inline until the attributes spill to the arena
+    XMLAttribute * m_attributes;
+    XMLAttribute m_inline[INLINE_ATTRIBUTES];
 };
 
 #endif // XMLNODE_H
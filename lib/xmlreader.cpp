@@ -0,0 +1,150 @@
+#include "xmlreader.h"
+
+XMLReader::XMLReader(QIODevice *device, int chunk_size)
+    : m_input(device),
+      m_chunk_size(chunk_size),
+      m_at_end(false),
+      m_buffer(),
+      m_pos(0),
+      m_state(Outside),
+      m_pending(XMLToken::End),
+      m_event(EndDocument),
+      m_name(),
+      m_value(),
+      m_selfclosing(false),
+      m_open()
+{
+    // the devices of the trees are UTF-8 whatever the locale is
+    m_input.setCodec("UTF-8");
+    m_buffer.reserve(chunk_size + 16);
+}
+
+XMLReader::Event XMLReader::next()
+{
+    XMLToken token;
+    m_selfclosing = false;
+
+    while(true) {
+        switch(m_state) {
+        case Outside: {
+            XMLToken::Kind kind = m_pending;
+            m_pending = XMLToken::End;
+
+            // search for the start of the node
+            while(kind != XMLToken::Open && kind != XMLToken::EndOpen) {
+                if(!read_token(token))
+                    return m_event = EndDocument;
+                kind = token.kind;
+            }
+
+            // closing tag
+            // in a syntactically correct XML it closes the last open node
+            if(kind == XMLToken::EndOpen) {
+                if(m_open.isEmpty())
+                    continue;
+                m_name = m_open.pop();
+                return m_event = EndElement;
+            }
+
+            // opening tag
+            if(!read_significant(token))
+                return m_event = EndDocument;
+
+            m_name = text(token).toString();
+            m_open.push(m_name);
+            m_state = InTag;
+            return m_event = StartElement;
+        }
+
+        case InTag:
+            if(!read_significant(token))
+                return m_event = EndDocument;
+
+            if(token.kind == XMLToken::SelfClose) {
+                m_selfclosing = true;
+                m_name = m_open.pop();
+                m_state = Outside;
+                return m_event = EndElement;
+            }
+
+            if(token.kind == XMLToken::Close) {
+                m_state = Content;
+                continue;
+            }
+
+            // attribute value should proceed an "="
+            m_name = text(token).toString();
+            if(!read_significant(token) || token.kind != XMLToken::Equal)
+                throw QString("Expected = near index");
+            if(!read_significant(token))
+                throw QString("Expected attribute value");
+
+            m_value = text(token).toString();
+            return m_event = Attribute;
+
+        case Content:
+            // extract node value
+            // including white spaces
+            m_value.resize(0);
+            while(read_token(token)) {
+                if(token.kind == XMLToken::Open || token.kind == XMLToken::EndOpen) {
+                    m_pending = token.kind;
+                    break;
+                }
+                const QStringView value = text(token);
+                m_value.append(value.data(), int(value.size()));
+            }
+
+            m_state = Outside;
+            m_value = m_value.trimmed();
+            if(!m_value.isEmpty())
+                return m_event = Text;
+            continue;
+        }
+    }
+}
+
+bool XMLReader::read_token(XMLToken &token)
+{
+    while(true) {
+        XMLScanner scanner(m_buffer.constData() + m_pos, m_buffer.size() - m_pos);
+        scanner.set_partial(!m_at_end);
+
+        if(scanner.next(token)) {
+            token.offset += m_pos;
+            m_pos = token.offset + token.length;
+            return true;
+        }
+
+        m_pos += scanner.position();
+        if(m_at_end)
+            return false;
+
+        fill();
+    }
+}
+
+bool XMLReader::read_significant(XMLToken &token)
+{
+    while(read_token(token)) {
+        if(token.kind != XMLToken::WhiteSpace)
+            return true;
+    }
+    return false;
+}
+
+bool XMLReader::fill()
+{
+    // keep only the token which straddles the chunks
+    m_buffer.remove(0, m_pos);
+    m_pos = 0;
+
+    const QString chunk = m_input.read(m_chunk_size);
+    if(chunk.isEmpty()) {
+        m_at_end = true;
+        return false;
+    }
+
+    m_buffer += chunk;
+    return true;
+}
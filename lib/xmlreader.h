@@ -0,0 +1,138 @@
+#ifndef XMLREADER_H
+#define XMLREADER_H
+
+#include <QIODevice>
+#include <QStack>
+#include <QString>
+#include <QTextStream>
+
+#include "lib/xmlscanner.h"
+
+/**
+ * @brief The XMLReader class
+ *        Pull reader that walks an XML document as a stream of events
+ *        it reads the device in fixed-size chunks and only keeps
+ *        the unscanned part of the current chunk, the names of
+ *        the open elements and the text of the current node
+ *        so its memory is proportional to the nesting depth
+ *        rather than the size of the document
+ *
+ *        it sees the document the same way XMLTree::load does
+ *        the value of a node is the text between its opening tag
+ *        and the first tag that follows, meta data, comments
+ *        outside the values and text after child nodes are ignored
+ *        the XML must be syntactically correct
+ */
+class XMLReader
+{
+public:
+    enum Event {
+        StartElement,   // name() is the tag of the node
+        Attribute,      // name() and value() of one attribute
+        Text,           // value() is the trimmed value of the node
+        EndElement,     // name() is the tag of the closed node
+        EndDocument
+    };
+
+    /**
+     * @brief XMLReader
+     *        construct a reader over an opened device
+     * @param chunk_size number of characters read at a time
+     */
+    explicit XMLReader(QIODevice *device, int chunk_size = 64 * 1024);
+
+    /**
+     * @brief next
+     *        advance to the next event
+     * @return the event
+     * @complexity O(length of(the text scanned for the event))
+     */
+    Event next();
+
+    /**
+     * @brief event
+     * @return the current event
+     */
+    Event event() const { return m_event; }
+
+    /**
+     * @brief name
+     * @return the tag of the current node or
+     *         the name of the current attribute
+     */
+    const QString &name() const { return m_name; }
+
+    /**
+     * @brief value
+     * @return the value of the current attribute or text
+     */
+    const QString &value() const { return m_value; }
+
+    /**
+     * @brief is_selfclosing
+     * @return true if the current EndElement closes
+     *         a self closing node
+     */
+    bool is_selfclosing() const { return m_selfclosing; }
+
+    /**
+     * @brief depth
+     * @return number of the open nodes
+     */
+    int depth() const { return m_open.size(); }
+
+private:
+    enum State {
+        Outside,    // between nodes
+        InTag,      // after the tag of an opening tag
+        Content     // after an opening tag
+    };
+
+    /**
+     * @brief read_token
+     *        read the next token refilling the buffer if needed
+     *        the text of the token is valid until the next call
+     * @return false at the end of the document
+     */
+    bool read_token(XMLToken &token);
+
+    /**
+     * @brief read_significant
+     *        read the next token which isn't a white space
+     * @return false at the end of the document
+     */
+    bool read_significant(XMLToken &token);
+
+    /**
+     * @brief fill
+     *        drop the scanned characters and read the next chunk
+     * @return false if the device has no more data
+     */
+    bool fill();
+
+    /**
+     * @brief text
+     * @return view of the characters of the token
+     */
+    QStringView text(const XMLToken &token) const
+    {
+        return QStringView(m_buffer.constData() + token.offset, token.length);
+    }
+
+    QTextStream m_input;
+    int m_chunk_size;
+    bool m_at_end;
+
+    QString m_buffer;
+    int m_pos;
+
+    State m_state;
+    XMLToken::Kind m_pending;
+    Event m_event;
+    QString m_name;
+    QString m_value;
+    bool m_selfclosing;
+    QStack<QString> m_open;
+};
+
+#endif // XMLREADER_H
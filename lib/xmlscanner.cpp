@@ -0,0 +1,622 @@
+#include "xmlscanner.h"
+
+#include <QThreadPool>
+#include <QtAlgorithms>
+#include <QtConcurrent>
+
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+enum CharClass : uchar {
+    Space   = 1,
+    Word    = 2,
+    Literal = 4
+};
+
+/**
+ * @brief The AsciiTable struct
+ *        character classes of the ASCII range
+ *        built at compile time from the token regex
+ *        word    [\w\.\$\%\^\&\#\@\*\(\-\+\-\):']
+ *        literal [\w\s\.\$\%\^\&\#\@\*\(\-\+\-\):/'`,;]
+ */
+struct AsciiTable {
+    uchar classes[128];
+
+    constexpr AsciiTable() : classes()
+    {
+        for(int c = 0; c < 128; ++c) {
+            if((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                    (c >= '0' && c <= '9') || c == '_')
+                classes[c] |= Word | Literal;
+            if(c == ' ' || (c >= '\t' && c <= '\r'))
+                classes[c] |= Space | Literal;
+        }
+
+        const char word[] = ".$%^&#@*(-+):'";
+        for(const char *c = word; *c; ++c)
+            classes[int(*c)] |= Word | Literal;
+
+        const char literal[] = "/`,;";
+        for(const char *c = literal; *c; ++c)
+            classes[int(*c)] |= Literal;
+    }
+};
+
+constexpr AsciiTable ascii_table;
+
+/**
+ * @brief alnum_run
+ * @return index of the first character at or after i
+ *         which is not an ASCII letter or digit
+ *         it may stop early, the caller continues scalar
+ */
+inline int alnum_run(const ushort *p, int i, int n)
+{
+#if defined(__AVX2__)
+    const __m256i lower_a = _mm256_set1_epi16('a' - 1);
+    const __m256i lower_z = _mm256_set1_epi16('z' + 1);
+    const __m256i digit_0 = _mm256_set1_epi16('0' - 1);
+    const __m256i digit_9 = _mm256_set1_epi16('9' + 1);
+    const __m256i to_lower = _mm256_set1_epi16(0x20);
+
+    while(i + 16 <= n) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+        const __m256i l = _mm256_or_si256(v, to_lower);
+        const __m256i alpha = _mm256_and_si256(_mm256_cmpgt_epi16(l, lower_a),
+                                               _mm256_cmpgt_epi16(lower_z, l));
+        const __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi16(v, digit_0),
+                                               _mm256_cmpgt_epi16(digit_9, v));
+        const uint mask = ~uint(_mm256_movemask_epi8(_mm256_or_si256(alpha, digit)));
+        if(mask)
+            return i + int(qCountTrailingZeroBits(mask)) / 2;
+        i += 16;
+    }
+#elif defined(__SSE2__)
+    const __m128i lower_a = _mm_set1_epi16('a' - 1);
+    const __m128i lower_z = _mm_set1_epi16('z' + 1);
+    const __m128i digit_0 = _mm_set1_epi16('0' - 1);
+    const __m128i digit_9 = _mm_set1_epi16('9' + 1);
+    const __m128i to_lower = _mm_set1_epi16(0x20);
+
+    while(i + 8 <= n) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+        const __m128i l = _mm_or_si128(v, to_lower);
+        const __m128i alpha = _mm_and_si128(_mm_cmpgt_epi16(l, lower_a),
+                                            _mm_cmplt_epi16(l, lower_z));
+        const __m128i digit = _mm_and_si128(_mm_cmpgt_epi16(v, digit_0),
+                                            _mm_cmplt_epi16(v, digit_9));
+        const uint mask = ~uint(_mm_movemask_epi8(_mm_or_si128(alpha, digit))) & 0xffff;
+        if(mask)
+            return i + int(qCountTrailingZeroBits(mask)) / 2;
+        i += 8;
+    }
+#endif
+    return i;
+}
+
+/**
+ * @brief space_run
+ * @return index of the first character at or after i
+ *         which is not one of ' ', '\n', '\r', '\t'
+ *         it may stop early, the caller continues scalar
+ */
+inline int space_run(const ushort *p, int i, int n)
+{
+#if defined(__AVX2__)
+    const __m256i space = _mm256_set1_epi16(' ');
+    const __m256i new_line = _mm256_set1_epi16('\n');
+    const __m256i carriage = _mm256_set1_epi16('\r');
+    const __m256i tab = _mm256_set1_epi16('\t');
+
+    while(i + 16 <= n) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+        const __m256i hits = _mm256_or_si256(
+                    _mm256_or_si256(_mm256_cmpeq_epi16(v, space), _mm256_cmpeq_epi16(v, new_line)),
+                    _mm256_or_si256(_mm256_cmpeq_epi16(v, carriage), _mm256_cmpeq_epi16(v, tab)));
+        const uint mask = ~uint(_mm256_movemask_epi8(hits));
+        if(mask)
+            return i + int(qCountTrailingZeroBits(mask)) / 2;
+        i += 16;
+    }
+#elif defined(__SSE2__)
+    const __m128i space = _mm_set1_epi16(' ');
+    const __m128i new_line = _mm_set1_epi16('\n');
+    const __m128i carriage = _mm_set1_epi16('\r');
+    const __m128i tab = _mm_set1_epi16('\t');
+
+    while(i + 8 <= n) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+        const __m128i hits = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi16(v, space), _mm_cmpeq_epi16(v, new_line)),
+                    _mm_or_si128(_mm_cmpeq_epi16(v, carriage), _mm_cmpeq_epi16(v, tab)));
+        const uint mask = ~uint(_mm_movemask_epi8(hits)) & 0xffff;
+        if(mask)
+            return i + int(qCountTrailingZeroBits(mask)) / 2;
+        i += 8;
+    }
+#endif
+    return i;
+}
+
+/**
+ * @brief alnum_run
+ *        the same for UTF-8 bytes
+ */
+inline int alnum_run(const uchar *p, int i, int n)
+{
+#if defined(__AVX2__)
+    const __m256i lower_a = _mm256_set1_epi8('a' - 1);
+    const __m256i lower_z = _mm256_set1_epi8('z' + 1);
+    const __m256i digit_0 = _mm256_set1_epi8('0' - 1);
+    const __m256i digit_9 = _mm256_set1_epi8('9' + 1);
+    const __m256i to_lower = _mm256_set1_epi8(0x20);
+
+    while(i + 32 <= n) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+        const __m256i l = _mm256_or_si256(v, to_lower);
+        const __m256i alpha = _mm256_and_si256(_mm256_cmpgt_epi8(l, lower_a),
+                                               _mm256_cmpgt_epi8(lower_z, l));
+        const __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(v, digit_0),
+                                               _mm256_cmpgt_epi8(digit_9, v));
+        const uint mask = ~uint(_mm256_movemask_epi8(_mm256_or_si256(alpha, digit)));
+        if(mask)
+            return i + int(qCountTrailingZeroBits(mask));
+        i += 32;
+    }
+#elif defined(__SSE2__)
+    const __m128i lower_a = _mm_set1_epi8('a' - 1);
+    const __m128i lower_z = _mm_set1_epi8('z' + 1);
+    const __m128i digit_0 = _mm_set1_epi8('0' - 1);
+    const __m128i digit_9 = _mm_set1_epi8('9' + 1);
+    const __m128i to_lower = _mm_set1_epi8(0x20);
+
+    while(i + 16 <= n) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+        const __m128i l = _mm_or_si128(v, to_lower);
+        const __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(l, lower_a),
+                                            _mm_cmplt_epi8(l, lower_z));
+        const __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(v, digit_0),
+                                            _mm_cmplt_epi8(v, digit_9));
+        const uint mask = ~uint(_mm_movemask_epi8(_mm_or_si128(alpha, digit))) & 0xffff;
+        if(mask)
+            return i + int(qCountTrailingZeroBits(mask));
+        i += 16;
+    }
+#endif
+    return i;
+}
+
+/**
+ * @brief space_run
+ *        the same for UTF-8 bytes
+ */
+inline int space_run(const uchar *p, int i, int n)
+{
+#if defined(__AVX2__)
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i new_line = _mm256_set1_epi8('\n');
+    const __m256i carriage = _mm256_set1_epi8('\r');
+    const __m256i tab = _mm256_set1_epi8('\t');
+
+    while(i + 32 <= n) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+        const __m256i hits = _mm256_or_si256(
+                    _mm256_or_si256(_mm256_cmpeq_epi8(v, space), _mm256_cmpeq_epi8(v, new_line)),
+                    _mm256_or_si256(_mm256_cmpeq_epi8(v, carriage), _mm256_cmpeq_epi8(v, tab)));
+        const uint mask = ~uint(_mm256_movemask_epi8(hits));
+        if(mask)
+            return i + int(qCountTrailingZeroBits(mask));
+        i += 32;
+    }
+#elif defined(__SSE2__)
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i new_line = _mm_set1_epi8('\n');
+    const __m128i carriage = _mm_set1_epi8('\r');
+    const __m128i tab = _mm_set1_epi8('\t');
+
+    while(i + 16 <= n) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+        const __m128i hits = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, new_line)),
+                    _mm_or_si128(_mm_cmpeq_epi8(v, carriage), _mm_cmpeq_epi8(v, tab)));
+        const uint mask = ~uint(_mm_movemask_epi8(hits)) & 0xffff;
+        if(mask)
+            return i + int(qCountTrailingZeroBits(mask));
+        i += 16;
+    }
+#endif
+    return i;
+}
+
+/**
+ * @brief unicode_class
+ * @return the character classes of a character outside ASCII
+ */
+inline uchar unicode_class(uint c)
+{
+    // \s doesn't include the control characters outside ASCII
+    const QChar::Category category = QChar::category(c);
+    if(category == QChar::Separator_Space ||
+            category == QChar::Separator_Line ||
+            category == QChar::Separator_Paragraph)
+        return Space | Literal;
+
+    if(QChar::isLetterOrNumber(c) || QChar::isMark(c))
+        return Word | Literal;
+
+    return 0;
+}
+
+/**
+ * @brief char_class
+ * @return the character classes of the UTF-16 code unit at i
+ *         surrogates are in none of them
+ * @param length set to the number of code units of the character
+ */
+inline uchar char_class(const ushort *p, int i, int, int &length)
+{
+    length = 1;
+    const ushort c = p[i];
+    if(c < 128)
+        return ascii_table.classes[c];
+    if(QChar::isSurrogate(c))
+        return 0;
+    return unicode_class(c);
+}
+
+/**
+ * @brief char_class
+ * @return the character classes of the UTF-8 character at i
+ *         invalid sequences and characters outside the BMP
+ *         are in none of them as they aren't in UTF-16
+ * @param length set to the number of bytes of the character
+ *        it may go past n if the sequence is cut by the end
+ */
+inline uchar char_class(const uchar *p, int i, int n, int &length)
+{
+    const uchar c = p[i];
+    if(c < 128) {
+        length = 1;
+        return ascii_table.classes[c];
+    }
+
+    uint code;
+    uchar min_second = 0x80, max_second = 0xbf;
+    if(c >= 0xc2 && c <= 0xdf) {
+        length = 2;
+        code = c & 0x1f;
+    } else if(c >= 0xe0 && c <= 0xef) {
+        length = 3;
+        code = c & 0x0f;
+        // no overlong forms nor surrogates
+        if(c == 0xe0)
+            min_second = 0xa0;
+        else if(c == 0xed)
+            max_second = 0x9f;
+    } else if(c >= 0xf0 && c <= 0xf4) {
+        length = 4;
+        code = 0;
+    } else {
+        length = 1;
+        return 0;
+    }
+
+    if(i + length > n)
+        return 0;
+
+    if(p[i + 1] < min_second || p[i + 1] > max_second) {
+        length = 1;
+        return 0;
+    }
+    for(int k = 1; k < length; ++k) {
+        if((p[i + k] & 0xc0) != 0x80) {
+            length = 1;
+            return 0;
+        }
+        code = (code << 6) | (p[i + k] & 0x3f);
+    }
+
+    return length == 4 ? 0 : unicode_class(code);
+}
+
+/**
+ * @brief class_run
+ * @return index of the first character at or after i
+ *         which is not in the given classes
+ * @param open set if the run may continue past n
+ */
+template<typename Unit>
+inline int class_run(const Unit *p, int i, int n, uchar classes, bool &open)
+{
+    int length;
+    while(true) {
+        if(classes & Space)
+            i = space_run(p, i, n);
+        else if(classes & Word)
+            i = alnum_run(p, i, n);
+
+        if(i >= n)
+            break;
+
+        const uchar found = char_class(p, i, n, length);
+        if(i + length > n) {
+            open = true;
+            return i;
+        }
+        if(!(found & classes))
+            return i;
+        i += length;
+    }
+
+    open = true;
+    return n;
+}
+
+/**
+ * @brief The TokenChunk struct
+ *        a slice of the text tokenized by one thread
+ */
+struct TokenChunk
+{
+    int begin;
+    int end;
+    QVector<XMLToken> tokens;
+};
+
+// texts shorter than this are tokenized on the calling thread
+constexpr int parallel_threshold = 1 << 20;
+// so that every thread has enough work
+constexpr int min_chunk_size = 1 << 18;
+
+/**
+ * @brief tokenize_range
+ *        append the tokens of the characters in [begin, end)
+ *        with their offsets relative to the start of data
+ */
+template<typename Encoding>
+void tokenize_range(const typename Encoding::Char *data, int begin, int end,
+                    QVector<XMLToken> &tokens)
+{
+    XMLBasicScanner<Encoding> scanner(data + begin, end - begin);
+    XMLToken token;
+
+    while(scanner.next(token)) {
+        token.offset += begin;
+        tokens.append(token);
+    }
+}
+
+} // namespace
+
+template<typename Encoding>
+XMLBasicScanner<Encoding>::XMLBasicScanner(const Char *data, int size)
+    : m_data(reinterpret_cast<const Unit *>(data)),
+      m_size(size),
+      m_pos(0),
+      m_partial(false)
+{
+
+}
+
+template<typename Encoding>
+XMLBasicScanner<Encoding>::XMLBasicScanner(const Text &str)
+    : XMLBasicScanner(str.constData(), str.size())
+{
+
+}
+
+template<typename Encoding>
+bool XMLBasicScanner<Encoding>::is_space(uint c)
+{
+    if(c < 128)
+        return ascii_table.classes[c] & Space;
+
+    return unicode_class(c) & Space;
+}
+
+template<typename Encoding>
+bool XMLBasicScanner<Encoding>::is_word(uint c)
+{
+    if(c < 128)
+        return ascii_table.classes[c] & Word;
+
+    return unicode_class(c) & Word;
+}
+
+template<typename Encoding>
+bool XMLBasicScanner<Encoding>::is_literal(uint c)
+{
+    if(c < 128)
+        return ascii_table.classes[c] & Literal;
+
+    return unicode_class(c) & Literal;
+}
+
+template<typename Encoding>
+bool XMLBasicScanner<Encoding>::next(XMLToken &token)
+{
+    const Unit *p = m_data;
+    const int n = m_size;
+    int i = m_pos;
+
+    while(i < n) {
+        // the longest lookahead is "<!--"
+        // also the longest UTF-8 sequence
+        if(m_partial && i + 3 >= n)
+            break;
+
+        const Unit c = p[i];
+        XMLToken::Kind kind = XMLToken::End;
+        int end = i;
+        // the token may continue past the end of the text
+        bool open = false;
+
+        switch(c) {
+        case '<':
+            kind = XMLToken::Open;
+            end = i + 1;
+            if(end < n && p[end] == '/') {
+                kind = XMLToken::EndOpen;
+                ++end;
+            } else if(end < n && p[end] == '?') {
+                kind = XMLToken::MetaOpen;
+                ++end;
+            } else if(i + 3 < n && p[i + 1] == '!' && p[i + 2] == '-' && p[i + 3] == '-') {
+                kind = XMLToken::CommentOpen;
+                end = i + 4;
+            }
+            break;
+        case '>':
+            kind = XMLToken::Close;
+            end = i + 1;
+            break;
+        case '=':
+            kind = XMLToken::Equal;
+            end = i + 1;
+            break;
+        case '/':
+        case '?':
+            if(i + 1 < n && p[i + 1] == '>') {
+                kind = c == '/' ? XMLToken::SelfClose : XMLToken::MetaClose;
+                end = i + 2;
+            }
+            break;
+        case '"':
+            // literal strings must have at least one character
+            end = i + 1;
+            if(end < n)
+                end = class_run(p, end, n, Literal, open);
+            else
+                open = true;
+            if(end > i + 1 && end < n && p[end] == '"') {
+                kind = XMLToken::Literal;
+                ++end;
+            } else {
+                end = i;
+            }
+            break;
+        case '-':
+            if(i + 2 < n && p[i + 1] == '-' && p[i + 2] == '>') {
+                kind = XMLToken::CommentClose;
+                end = i + 3;
+                break;
+            }
+            Q_FALLTHROUGH();
+        default: {
+            int length;
+            const uchar classes = char_class(p, i, n, length);
+            if(classes & Space) {
+                kind = XMLToken::WhiteSpace;
+                end = class_run(p, i + length, n, Space, open);
+            } else if(classes & Word) {
+                kind = XMLToken::Word;
+                end = class_run(p, i + length, n, Word, open);
+            }
+            break;
+        }
+        }
+
+        if(open && m_partial)
+            break;
+
+        // the character can't start any token
+        if(end == i) {
+            ++i;
+            continue;
+        }
+
+        token.kind = kind;
+        token.offset = i;
+        token.length = end - i;
+        m_pos = end;
+        return true;
+    }
+
+    m_pos = i;
+    return false;
+}
+
+template<typename Encoding>
+typename Encoding::TextList XMLBasicScanner<Encoding>::tokenize(const Text &str)
+{
+    typename Encoding::TextList list;
+    XMLBasicScanner scanner(str);
+    XMLToken token;
+
+    while(scanner.next(token))
+        list << str.mid(token.offset, token.length);
+
+    return list;
+}
+
+template<typename Encoding>
+XMLBasicTokenList<Encoding>::XMLBasicTokenList(const Text &text, int threads)
+    : m_text(text)
+{
+    const typename Encoding::Char *data = m_text.constData();
+    const int n = m_text.size();
+
+    if(threads <= 0)
+        threads = QThreadPool::globalInstance()->maxThreadCount();
+    threads = qMin(threads, n / min_chunk_size);
+
+    if(n < parallel_threshold || threads < 2) {
+        // markup is dense in XML, a token every few characters
+        m_tokens.reserve(n / 4 + 16);
+        tokenize_range<Encoding>(data, 0, n, m_tokens);
+        return;
+    }
+
+    // a "<" always starts a token and no token has it in the middle
+    // so the tokens of the slices between them are the same
+    // as the tokens of the whole text
+    QVector<TokenChunk> chunks;
+    int begin = 0;
+    for(int k = 1; k < threads; ++k) {
+        const int share = int(qint64(n) * k / threads);
+        if(share <= begin)
+            continue;
+
+        const int split = int(std::find(data + share, data + n,
+                                        typename Encoding::Char('<')) - data);
+        if(split == n)
+            break;
+
+        chunks.append({begin, split, QVector<XMLToken>()});
+        begin = split;
+    }
+    chunks.append({begin, n, QVector<XMLToken>()});
+
+    QtConcurrent::blockingMap(chunks, [data](TokenChunk &chunk) {
+        chunk.tokens.reserve((chunk.end - chunk.begin) / 4 + 16);
+        tokenize_range<Encoding>(data, chunk.begin, chunk.end, chunk.tokens);
+    });
+
+    int size = 0;
+    for(const TokenChunk &chunk : qAsConst(chunks))
+        size += chunk.tokens.size();
+
+    m_tokens.reserve(size);
+    for(const TokenChunk &chunk : qAsConst(chunks))
+        m_tokens += chunk.tokens;
+}
+
+template<typename Encoding>
+int XMLBasicTokenList<Encoding>::lines(int i) const
+{
+    const typename Encoding::View token = text(i);
+    return int(std::count(token.begin(), token.end(), typename Encoding::Char('\n')));
+}
+
+template class XMLBasicScanner<XMLUtf16>;
+template class XMLBasicScanner<XMLUtf8>;
+template class XMLBasicTokenList<XMLUtf16>;
+template class XMLBasicTokenList<XMLUtf8>;
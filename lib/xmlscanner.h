@@ -0,0 +1,258 @@
+#ifndef XMLSCANNER_H
+#define XMLSCANNER_H
+
+#include <QByteArray>
+#include <QByteArrayList>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+#include <QVector>
+
+#include <string_view>
+
+/**
+ * @brief The XMLToken struct
+ *        A token as a span of the scanned text
+ *        it doesn't own or copy any characters
+ */
+struct XMLToken
+{
+    enum Kind : uchar {
+        Open,           // <
+        Close,          // >
+        EndOpen,        // </
+        Equal,          // =
+        SelfClose,      // />
+        CommentOpen,    // <!--
+        CommentClose,   // -->
+        MetaOpen,       // <?
+        MetaClose,      // ?>
+        WhiteSpace,
+        Literal,
+        Word,
+        End             // past the last token
+    };
+
+    Kind kind;
+    int offset;
+    int length;
+
+    /**
+     * @brief is_markup
+     * @return true if the token is a special XML token
+     */
+    bool is_markup() const { return kind <= MetaClose; }
+};
+
+/**
+ * @brief The XMLUtf16 struct
+ *        Text held in a QString as UTF-16 code units
+ */
+struct XMLUtf16
+{
+    using Text = QString;
+    using TextList = QStringList;
+    using View = QStringView;
+    using Char = QChar;
+    using Unit = ushort;
+
+    static QString decode(const QString &text) { return text; }
+    static QString decode(QStringView text) { return text.toString(); }
+};
+
+/**
+ * @brief The XMLUtf8 struct
+ *        Text held in a QByteArray as UTF-8 bytes
+ */
+struct XMLUtf8
+{
+    using Text = QByteArray;
+    using TextList = QByteArrayList;
+    using View = std::string_view;
+    using Char = char;
+    using Unit = uchar;
+
+    static QString decode(const QByteArray &text) { return QString::fromUtf8(text); }
+    static QString decode(std::string_view text)
+    {
+        return QString::fromUtf8(text.data(), int(text.size()));
+    }
+};
+
+/**
+ * @brief The XMLBasicTokenList class
+ *        The tokens of an XML text stored as spans
+ *        of the text it holds a shallow copy of
+ *        tokenizing allocates a single growing array
+ *        instead of a string per token
+ */
+template<typename Encoding>
+class XMLBasicTokenList
+{
+public:
+    using Text = typename Encoding::Text;
+    using View = typename Encoding::View;
+
+    /**
+     * @brief XMLBasicTokenList
+     *        tokenize the given text
+     *        large texts are split before a "<" into slices
+     *        which are tokenized concurrently
+     * @param threads the maximum number of slices
+     *        0 uses the size of the global thread pool
+     * @complexity O(length of(text) / threads)
+     */
+    explicit XMLBasicTokenList(const Text &text, int threads = 0);
+
+    /**
+     * @brief size
+     * @return number of tokens
+     */
+    int size() const { return m_tokens.size(); }
+
+    /**
+     * @brief kind
+     * @return kind of the token at index i
+     *         End if i is past the last token
+     */
+    XMLToken::Kind kind(int i) const
+    {
+        return i < m_tokens.size() ? m_tokens[i].kind : XMLToken::End;
+    }
+
+    /**
+     * @brief text
+     * @return view of the characters of the token at index i
+     */
+    View text(int i) const
+    {
+        const XMLToken &token = m_tokens[i];
+        return View(m_text.constData() + token.offset, token.length);
+    }
+
+    /**
+     * @brief lines
+     * @return number of new lines in the token at index i
+     */
+    int lines(int i) const;
+
+    /**
+     * @brief operator []
+     * @return the token at index i
+     */
+    const XMLToken &operator[](int i) const { return m_tokens[i]; }
+
+    /**
+     * @brief source
+     * @return the tokenized text
+     */
+    const Text &source() const { return m_text; }
+
+private:
+    Text m_text;
+    QVector<XMLToken> m_tokens;
+};
+
+using XMLTokenList = XMLBasicTokenList<XMLUtf16>;
+using XMLUtf8TokenList = XMLBasicTokenList<XMLUtf8>;
+
+/**
+ * @brief The XMLBasicScanner class
+ *        Hand-written single pass scanner for XML text
+ *        it splits the text into the same tokens as the regex
+ *        ( xml tokens | white spaces | literal strings | words )
+ *        it picks the longest token at every position and skips
+ *        the characters that can't start any token
+ *
+ *        it scans UTF-16 or UTF-8 text, both give the same tokens
+ *        characters outside the BMP are never part of a token
+ *        the same as their UTF-16 surrogates
+ *
+ *        runs of white spaces and alphanumeric characters are
+ *        scanned with SSE2/AVX2 when they are available
+ */
+template<typename Encoding>
+class XMLBasicScanner
+{
+public:
+    using Text = typename Encoding::Text;
+    using Char = typename Encoding::Char;
+    using Unit = typename Encoding::Unit;
+
+    /**
+     * @brief XMLBasicScanner
+     *        construct a scanner over the given characters
+     *        the characters must outlive the scanner
+     */
+    XMLBasicScanner(const Char *data, int size);
+
+    /**
+     * @brief XMLBasicScanner
+     *        construct a scanner over the given string
+     *        the string must outlive the scanner
+     */
+    explicit XMLBasicScanner(const Text &str);
+
+    /**
+     * @brief next
+     *        find the next token starting from the current position
+     * @param token filled with the kind and the span of the token
+     * @return false if there are no more tokens
+     *         or if the text is partial and the next token
+     *         may continue past its end
+     * @complexity O(length of(token) + skipped characters)
+     */
+    bool next(XMLToken &token);
+
+    /**
+     * @brief position
+     * @return the index of the first character not scanned yet
+     *         the start of the pending token for partial texts
+     */
+    int position() const { return m_pos; }
+
+    /**
+     * @brief set_partial
+     *        mark the text as a prefix of a longer text
+     *        tokens which may straddle its end are not returned
+     *        until the scanner is given the rest of the text
+     */
+    void set_partial(bool partial) { m_partial = partial; }
+
+    /**
+     * @brief tokenize
+     * @return list of XML tokens as well as white spaces
+     * @complexity O(length of(str))
+     */
+    static typename Encoding::TextList tokenize(const Text &str);
+
+    /**
+     * @brief is_space
+     * @return true if the character matches \s
+     */
+    static bool is_space(uint c);
+
+    /**
+     * @brief is_word
+     * @return true if the character can be a part of a word
+     */
+    static bool is_word(uint c);
+
+    /**
+     * @brief is_literal
+     * @return true if the character can be a part of
+     *         a double quoted literal string
+     */
+    static bool is_literal(uint c);
+
+private:
+    const Unit *m_data;
+    int m_size;
+    int m_pos;
+    bool m_partial;
+};
+
+using XMLScanner = XMLBasicScanner<XMLUtf16>;
+using XMLUtf8Scanner = XMLBasicScanner<XMLUtf8>;
+
+#endif // XMLSCANNER_H
@@ -0,0 +1,104 @@
+#include "xmlsymbols.h"
+
+namespace {
+
+// names longer than this are decoded before they are looked up
+constexpr int max_ascii_name = 128;
+
+} // namespace
+
+XMLSymbolTable::XMLSymbolTable()
+    : m_names(),
+      m_hashes(),
+      m_slots()
+{
+    clear();
+}
+
+uint XMLSymbolTable::hash(QStringView name)
+{
+    uint hash = 2166136261u;
+    for(const QChar c : name) {
+        hash ^= c.unicode();
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+int XMLSymbolTable::slot(QStringView name, uint hash) const
+{
+    const int mask = m_slots.size() - 1;
+    int i = int(hash) & mask;
+
+    // linear probing, the table is never full
+    while(m_slots[i] >= 0) {
+        const int id = m_slots[i];
+        if(m_hashes[id] == hash && QStringView(m_names[id]) == name)
+            break;
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+int XMLSymbolTable::find(QStringView name) const
+{
+    return m_slots[slot(name, hash(name))];
+}
+
+int XMLSymbolTable::intern(QStringView name)
+{
+    const uint h = hash(name);
+    int i = slot(name, h);
+    if(m_slots[i] >= 0)
+        return m_slots[i];
+
+    const int id = m_names.size();
+    m_names.push_back(name.toString());
+    m_hashes.push_back(h);
+    m_slots[i] = id;
+
+    // keep the load factor under a half
+    if(m_names.size() * 2 > m_slots.size())
+        rehash(m_slots.size() * 2);
+
+    return id;
+}
+
+int XMLSymbolTable::intern(std::string_view name)
+{
+    if(name.size() <= size_t(max_ascii_name)) {
+        QChar buffer[max_ascii_name];
+        int size = 0;
+        for(const char c : name) {
+            if(uchar(c) >= 0x80)
+                break;
+            buffer[size++] = QChar(ushort(uchar(c)));
+        }
+        if(size_t(size) == name.size())
+            return intern(QStringView(buffer, size));
+    }
+
+    return intern(QStringView(QString::fromUtf8(name.data(), int(name.size()))));
+}
+
+void XMLSymbolTable::rehash(int capacity)
+{
+    m_slots.fill(-1, capacity);
+    const int mask = capacity - 1;
+    for(int id = 0; id < m_names.size(); ++id) {
+        int i = int(m_hashes[id]) & mask;
+        while(m_slots[i] >= 0)
+            i = (i + 1) & mask;
+        m_slots[i] = id;
+    }
+}
+
+void XMLSymbolTable::clear()
+{
+    m_names.clear();
+    m_hashes.clear();
+    m_slots.fill(-1, 64);
+
+    // the empty name is always 0
+    intern(QStringView());
+}
@@ -0,0 +1,96 @@
+#ifndef XMLSYMBOLS_H
+#define XMLSYMBOLS_H
+
+#include <QString>
+#include <QStringView>
+#include <QVector>
+
+#include <string_view>
+
+/**
+ * @brief The XMLSymbolTable class
+ *        Interned names of a tree
+ *        every distinct tag name and attribute key is stored once
+ *        and identified by a small integer id, so equal names
+ *        have equal ids and are compared as integers
+ *
+ *        the id 0 is the empty name
+ */
+class XMLSymbolTable
+{
+public:
+    /**
+     * @brief XMLSymbolTable
+     *        Default constructor
+     *        the table holds only the empty name
+     */
+    XMLSymbolTable();
+
+    /**
+     * @brief intern
+     * @return id of the name, it's added if it's not in the table
+     * @complexity amortized O(length of(name))
+     */
+    int intern(QStringView name);
+
+    /**
+     * @brief intern
+     * @return id of the UTF-8 name
+     *         ASCII names are looked up without decoding them
+     * @complexity amortized O(length of(name))
+     */
+    int intern(std::string_view name);
+
+    /**
+     * @brief find
+     * @return id of the name or -1 if it's not in the table
+     * @complexity O(length of(name))
+     */
+    int find(QStringView name) const;
+
+    /**
+     * @brief name
+     * @return the name of the id
+     *         copies of it share the same characters
+     */
+    const QString &name(int id) const { return m_names[id]; }
+
+    /**
+     * @brief size
+     * @return number of distinct names
+     */
+    int size() const { return m_names.size(); }
+
+    /**
+     * @brief clear
+     *        remove all the names but the empty one
+     */
+    void clear();
+
+private:
+    /**
+     * @brief hash
+     * @return FNV-1a hash of the UTF-16 code units of the name
+     */
+    static uint hash(QStringView name);
+
+    /**
+     * @brief slot
+     * @return index of the slot holding the name
+     *         or of the empty slot where it belongs
+     */
+    int slot(QStringView name, uint hash) const;
+
+    /**
+     * @brief rehash
+     *        grow the slots to the given power of two
+     */
+    void rehash(int capacity);
+
+    QVector<QString> m_names;
+    QVector<uint> m_hashes;
+    // ids of the names by hash, -1 for empty slots
+    QVector<int> m_slots;
+};
+
+#endif // XMLSYMBOLS_H
@@ -1,186 +1,942 @@
 #include "xmltree.h"
+#include "xmldocument.h"
+#include "xmlscanner.h"
+#include "dumplayout.h"
+#include "indenttable.h"
+#include "textoutput.h"
 #include <QFile>
+#include <QScopedPointer>
 #include <QStringBuilder>
 #include <QTextStream>
 #include <iostream>
 #include <QStack>
 #include <QFileInfo>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+namespace {
+
+// token lists shorter than this are checked on the calling thread
+constexpr int parallel_check_threshold = 1 << 18;
+// so that every thread has enough work
+constexpr int min_check_slice = 1 << 16;
+
+} // namespace
 
 XMLTree::XMLTree()
-    : m_root(nullptr), m_size(0)
+    : m_root(nullptr), m_size(0), m_file(nullptr)
 {
 
 }
 
 XMLTree::~XMLTree()
 {
-    delete m_root;
+    clear();
+}
+
+XMLNode *XMLTree::create_node()
+{
+    return new (m_arena.allocate(sizeof(XMLNode), alignof(XMLNode))) XMLNode(this);
+}
+
+void XMLTree::clear()
+{
+    // the nodes are trivially destructible
+    // releasing the blocks releases all of them
+    m_arena.clear();
+    m_names.clear();
     m_root = nullptr;
+    m_size = 0;
+
+    m_utf16_source = QString();
+    m_utf8_source = QByteArray();
+    delete m_file;
+    m_file = nullptr;
+    m_skip_index.clear();
+}
+
+void XMLTree::retain_source(const QString &source)
+{
+    m_utf16_source = source;
+}
+
+void XMLTree::retain_source(const QByteArray &source)
+{
+    m_utf8_source = source;
 }
 
-QString XMLTree::dump(int spaces) const
+namespace {
+
+template<typename Encoding>
+QString value_text_helper(typename Encoding::View raw)
 {
+    // the value is the tokens of the text joined
+    // scanning the raw text again finds the same tokens
+    // as they start at the same "<" and end before the next one
+    typename Encoding::Text value;
+    value.reserve(int(raw.size()));
+    XMLBasicScanner<Encoding> scanner(raw.data(), int(raw.size()));
+    XMLToken token;
+    while(scanner.next(token))
+        value.append(raw.data() + token.offset, token.length);
+
+    return Encoding::decode(value).trimmed();
+}
+
+} // namespace
+
+QString XMLTree::source_value(int offset, int size) const
+{
+    if(m_utf8_source.size())
+        return value_text(std::string_view(m_utf8_source.constData() + offset, size_t(size)));
+    return value_text(QStringView(m_utf16_source.constData() + offset, size));
+}
+
+QString XMLTree::value_text(QStringView raw)
+{
+    return value_text_helper<XMLUtf16>(raw);
+}
+
+QString XMLTree::value_text(std::string_view raw)
+{
+    return value_text_helper<XMLUtf8>(raw);
+}
+
+QString XMLTree::dump(int spaces, QChar fill) const
+{
+    // size the text first to allocate it at once
+    TextSizeOutput sizes;
+    dump_stream(spaces, fill, sizes);
+
     QString builder;
-    QTextStream ts(&builder);
+    builder.resize(sizes.size());
+    TextBufferOutput output(builder.data());
+    dump_stream(spaces, fill, output);
+    Q_ASSERT(output.end() == builder.constData() + builder.size());
 
-    dump_helper(m_root, spaces, 0, ts);
+    return builder;
+
+}
+
+QByteArray XMLTree::dump_utf8(int spaces, QChar fill) const
+{
+    QByteArray builder;
+    QTextStream ts(&builder, QIODevice::WriteOnly);
+    ts.setCodec("UTF-8");
+
+    TextStreamOutput output(ts);
+    dump_stream(spaces, fill, output);
+    ts.flush();
 
     return builder;
+}
 
+void XMLTree::dump(QIODevice *device, int spaces, QChar fill) const
+{
+    QTextStream ts(device);
+    ts.setCodec("UTF-8");
+
+    TextStreamOutput output(ts);
+    dump_stream(spaces, fill, output);
+    ts.flush();
+}
+
+template<typename Output>
+void XMLTree::dump_stream(int spaces, QChar fill, Output &output) const
+{
+    if(spaces < 0) {
+        MinifiedLayout layout;
+        dump_helper(m_root, layout, 0, output);
+    } else {
+        IndentedLayout layout(spaces, fill);
+        dump_helper(m_root, layout, 0, output);
+    }
 }
 
-void  XMLTree::dump_helper(XMLNode * node, int spaces, int depth, QTextStream& output) const
+template<typename Layout, typename Output>
+void  XMLTree::dump_helper(XMLNode * node, Layout &layout, int depth, Output& output) const
 {
     if(node == nullptr)
         return;
 
-    QString indent;
-    QString end_line;
-    QString local_indent;
+    // the ancestors of the current node up to the given one
+    // a node stays open while its children are written
+    QStack<XMLNode *> open;
+
+    while(node) {
+        const int level = depth + open.size();
 
-    if(spaces >= 0) {
-        local_indent.reserve(spaces + 2);
-        for(int i = 0; i < spaces; i++)
-            local_indent += " ";
+        layout.indent(output, level);
+        output << "<" << m_names.name(node->m_tag);
 
-        indent.reserve(spaces * depth + 2);
-        for(int i = 0; i < depth; i++)
-            indent += local_indent;
+        for(int i = 0; i < node->m_attributes_size; ++i) {
+            const XMLAttribute &attribute = node->m_attributes[i];
+            output << " " << m_names.name(attribute.key) << "=" << attribute.value;
+        }
 
-        end_line = "\n";
+        if(node->m_selfclosing) {
+            output << "/>";
+            layout.end_line(output);
+        } else {
+            output << ">";
+            layout.end_line(output);
+
+            // a set value is written from the arena
+            // a loaded one is read in each pass
+            QString storage;
+            layout.write_value(output, node->value(storage), level + 1);
+
+            // building the children of a lazy node may add names
+            // to the table, no name is kept across it
+            XMLNode *child = node->first_child();
+            if(child) {
+                open.push(node);
+                node = child;
+                continue;
+            }
+
+            layout.indent(output, level);
+            output << "</" << m_names.name(node->m_tag) << ">";
+            layout.end_line(output);
+        }
+
+        // close the ancestors which have no more children
+        while(open.size() && !node->m_next_sibling) {
+            node = open.pop();
+            layout.indent(output, depth + open.size());
+            output << "</" << m_names.name(node->m_tag) << ">";
+            layout.end_line(output);
+        }
+        node = open.size() ? node->m_next_sibling : nullptr;
     }
+}
 
-    output << indent << "<" << node->m_tag;
+bool XMLTree::is_token(const QString& token) {
+    XMLScanner scanner(token);
+    XMLToken first;
+    return scanner.next(first) &&
+           first.is_markup() &&
+           first.offset == 0 &&
+           first.length == token.size();
+}
+
+XMLTokenList XMLTree::tokenize(QTextStream &input)
+{
+    return XMLTokenList(input.readAll());
+}
 
-    for(const auto& attribute : node->m_attributes)
-        output << " " << attribute.key << "=" << attribute.value << "";
+XMLNode *XMLTree::root() const
+{
+    return m_root;
+}
+
+int XMLTree::syntax_check(QTextStream &input, bool capture_all)
+{
+    // extract the tokens
+    const XMLTokenList list = tokenize(input);
+
+    const QVector<QPair<int, QString>> errors = check_tokens(list, capture_all);
+
+    if(capture_all && errors.size())
+        throw  errors;
+
+    return errors.empty();
+}
+
+int XMLTree::syntax_check(const QByteArray &input, bool capture_all)
+{
+    const XMLUtf8TokenList list(input);
+
+    const QVector<QPair<int, QString>> errors = check_tokens(list, capture_all);
+
+    if(capture_all && errors.size())
+        throw  errors;
+
+    return errors.empty();
+}
+
+void XMLTree::load(QTextStream &input)
+{
+    load_tokens(tokenize(input), false);
+}
 
-    if(node->m_selfclosing) {
-        output << "/>" << end_line;
+void XMLTree::load(const QByteArray &input)
+{
+    load_tokens(XMLUtf8TokenList(input), false);
+}
+
+void XMLTree::load(QTextStream &input, const QStringList &paths)
+{
+    load_lazy(input);
+    filter_paths(paths);
+}
+
+void XMLTree::load(const QByteArray &input, const QStringList &paths)
+{
+    load_lazy(input);
+    filter_paths(paths);
+}
+
+void XMLTree::load_checked(QTextStream &input)
+{
+    load_tokens(tokenize(input), true);
+}
+
+void XMLTree::load_checked(const QByteArray &input)
+{
+    load_tokens(XMLUtf8TokenList(input), true);
+}
+
+void XMLTree::load_file(const QString &path, bool lazy)
+{
+    QScopedPointer<QFile> file(new QFile(path));
+    if(!file->open(QFile::ReadOnly))
+        throw QString("Can't open " + path);
+
+    // parse the bytes of the mapping in place
+    // fall back to reading the file if it can't be mapped
+    const qint64 size = file->size();
+    const uchar *data = size > 0 ? file->map(0, size) : nullptr;
+    if(!data) {
+        if(lazy)
+            load_lazy(file->readAll());
+        else
+            load(file->readAll());
         return;
     }
 
-    output << ">" << end_line;
-    \
-    if(node->m_value != "") {
-        if(end_line != "") {
-            QStringList lines = node->m_value.split('\n');
-            for(int i = 0; i < lines.size(); ++i)
-                output << indent  << local_indent <<  lines[i].trimmed() << "\n";
-        } else {
-            output << node->m_value.simplified();
+    const QByteArray bytes = QByteArray::fromRawData(reinterpret_cast<const char *>(data), int(size));
+    if(lazy)
+        load_lazy(bytes);
+    else
+        load(bytes);
+
+    // the values are read from the mapping
+    // it's kept until the tree is cleared
+    m_file = file.take();
+}
+
+void XMLTree::load_lazy(QTextStream &input)
+{
+    clear();
+    retain_source(input.readAll());
+    load_lazy_source<XMLUtf16>(m_utf16_source);
+}
+
+void XMLTree::load_lazy(const QByteArray &input)
+{
+    clear();
+    retain_source(input);
+    load_lazy_source<XMLUtf8>(m_utf8_source);
+}
+
+template<typename Encoding>
+void XMLTree::load_lazy_source(const typename Encoding::Text &source)
+{
+    using View = typename Encoding::View;
+
+    // the start tags in document order and the ends of their subtrees
+    // a "<" starts an entry and a "</" with the same tag
+    // as the last open one ends it, the same as parse_helper
+    XMLBasicScanner<Encoding> scanner(source);
+    XMLToken token;
+    QStack<int> open;
+    QStack<View> tags;
+    // the start tag being scanned
+    int tag = -1;
+    View name;
+    // the token before the name of a tag
+    XMLToken::Kind before_name = XMLToken::End;
+    int size = 0;
+
+    while(scanner.next(token)) {
+        if(token.kind == XMLToken::WhiteSpace)
+            continue;
+
+        if(before_name == XMLToken::Open) {
+            before_name = XMLToken::End;
+            if(token.is_markup()) {
+                m_skip_index.pop_back();
+                tag = -1;
+            } else {
+                name = View(source.constData() + token.offset, token.length);
+            }
+            continue;
+        }
+
+        if(before_name == XMLToken::EndOpen) {
+            before_name = XMLToken::End;
+            if(!token.is_markup() && tags.size() &&
+                    tags.top() == View(source.constData() + token.offset, token.length)) {
+                tags.pop();
+                m_skip_index[open.pop()].next = m_skip_index.size();
+            }
+            continue;
+        }
+
+        switch(token.kind) {
+        case XMLToken::Open:
+            if(tag < 0) {
+                tag = m_skip_index.size();
+                m_skip_index.push_back({token.offset, tag + 1});
+                before_name = XMLToken::Open;
+            }
+            break;
+        case XMLToken::EndOpen:
+            if(tag < 0)
+                before_name = XMLToken::EndOpen;
+            break;
+        case XMLToken::Close:
+            if(tag >= 0) {
+                open.push(tag);
+                tags.push(name);
+                ++size;
+            }
+            tag = -1;
+            break;
+        case XMLToken::SelfClose:
+            if(tag >= 0)
+                ++size;
+            tag = -1;
+            break;
+        default:
+            break;
         }
     }
 
-    for(XMLNode * child : qAsConst(node->m_children))
-        dump_helper(child, spaces, depth + 1, output);
+    // a "<" at the end of the source starts nothing
+    if(before_name == XMLToken::Open)
+        m_skip_index.pop_back();
+
+    // the elements left open end with the source
+    while(open.size())
+        m_skip_index[open.pop()].next = m_skip_index.size();
+
+    m_root = create_node();
+    m_size = size;
+
+    // the top level elements are loaded like load does
+    // they are added as children of the root
+    // unless the root has none, then they replace it
+    const typename Encoding::View view(source.constData(), source.size());
+    for(int entry = 0; entry < m_skip_index.size(); entry = m_skip_index[entry].next) {
+        XMLNode *node = m_root;
+        if(!m_root->is_leaf()) {
+            node = create_node();
+            node->m_parent = m_root;
+            m_root->add_child(node);
+        }
+        load_entry<Encoding>(node, entry, view);
+    }
+}
 
-    output << indent << "</" << node->m_tag << ">" << end_line ;
+template<typename Encoding>
+typename Encoding::View XMLTree::entry_tag(const SkipEntry &entry, typename Encoding::View source)
+{
+    // the first token after the "<"
+    XMLBasicScanner<Encoding> scanner(source.data() + entry.begin, int(source.size()) - entry.begin);
+    XMLToken token;
+    scanner.next(token);
+    while(scanner.next(token))
+        if(token.kind != XMLToken::WhiteSpace)
+            break;
+    return typename Encoding::View(source.data() + entry.begin + token.offset, token.length);
 }
 
-bool XMLTree::is_token(const QString& token) {
-    const QRegExp xml_tokens { "<|>|</|=|/>|-->|<!--|<\\?|\\?>" };
-    return xml_tokens.exactMatch(token);
-}
-
-QStringList XMLTree::tokenize(QTextStream &input)
-{
-    // regex to tokize the XML text
-    const QString word { "[\\w\\.\\$\\%\\^\\&\\#\\@\\*\\(\\-\\+\\-\\):']+" };
-    const QString literal_string { "\"[\\w\\s\\.\\$\\%\\^\\&\\#\\@\\*\\(\\-\\+\\-\\):/'`,;]+\"" };
-    const QString white_spaces { "[\\s]+" };
-    const QString xml_tokens { "<|>|</|=|/>|-->|<!--|<\\?|\\?>" };
-
-    const QRegExp xml_rx { "(" + xml_tokens + "|"
-                               + white_spaces + "|"
-                               + literal_string + "|"
-                               + word + ")" };
-    int pos = 0;
-    QStringList list;
-    QString str = input.readAll();
-
-    // extract the capctured groups
-    while ((pos = xml_rx.indexIn(str, pos)) != -1) {
-        list << xml_rx.cap(1);
-        pos += xml_rx.matchedLength();
+template<typename Encoding>
+void XMLTree::load_entry(XMLNode *node, int entry, typename Encoding::View source)
+{
+    using View = typename Encoding::View;
+
+    // scan from the "<" of the start tag
+    const int begin = m_skip_index[entry].begin;
+    XMLBasicScanner<Encoding> scanner(source.data() + begin, int(source.size()) - begin);
+    XMLToken token;
+
+    auto next_token = [&scanner, &token]() {
+        while(scanner.next(token))
+            if(token.kind != XMLToken::WhiteSpace)
+                return true;
+        token.kind = XMLToken::End;
+        return false;
+    };
+    auto text = [&source, &token, begin]() {
+        return View(source.data() + begin + token.offset, token.length);
+    };
+
+    next_token();
+    next_token();
+    node->m_tag = m_names.intern(text());
+
+    // key = value up to the end of the tag
+    auto tag_end = [&token]() {
+        return token.kind == XMLToken::End ||
+               token.kind == XMLToken::Close ||
+               token.kind == XMLToken::SelfClose;
+    };
+    next_token();
+    while(!tag_end()) {
+        if(token.is_markup()) {
+            next_token();
+            continue;
+        }
+
+        const View key = text();
+        next_token();
+        if(tag_end())
+            break;
+        next_token();
+        if(tag_end())
+            break;
+        node->set_attribute({m_names.intern(key), m_arena.copy(text())});
+        next_token();
+    }
+
+    if(token.kind != XMLToken::Close) {
+        node->m_selfclosing = true;
+        return;
+    }
+
+    // the value is the text up to the next tag
+    int first = -1;
+    int last = -1;
+    while(scanner.next(token) &&
+          token.kind != XMLToken::Open &&
+          token.kind != XMLToken::EndOpen) {
+        if(first < 0)
+            first = token.offset;
+        last = token.offset + token.length;
     }
+    node->m_selfclosing = false;
+    node->m_source_offset = begin + qMax(first, 0);
+    node->m_source_size = last - first;
 
-    return list;
+    // the children are built when they are requested
+    if(m_skip_index[entry].next > entry + 1)
+        node->m_lazy = entry;
 }
 
-XMLNode *XMLTree::root() const
+void XMLTree::expand(XMLNode *node)
 {
-    return m_root;
+    if(m_utf8_source.size())
+        expand_helper<XMLUtf8>(node, std::string_view(m_utf8_source.constData(),
+                                                      size_t(m_utf8_source.size())));
+    else
+        expand_helper<XMLUtf16>(node, QStringView(m_utf16_source));
 }
 
-int XMLTree::syntax_check(QTextStream &input, bool capture_all)
+template<typename Encoding>
+void XMLTree::expand_helper(XMLNode *node, typename Encoding::View source)
 {
-    // extract the captured groups
-    QStringList list = tokenize(input);
+    const int entry = node->m_lazy;
+    node->m_lazy = -1;
+
+    // the children are the entries from the one after the node
+    // skipping the elements under every child
+    const int end = m_skip_index[entry].next;
+    for(int child = entry + 1; child < end; child = m_skip_index[child].next) {
+        XMLNode *created = create_node();
+        created->m_parent = node;
+        node->add_child(created);
+        load_entry<Encoding>(created, child, source);
+    }
+}
 
-    // regex to match white spaces
-    QRegExp white_spaces("[\\s]+");
+void XMLTree::filter_paths(const QStringList &paths)
+{
+    // the tags of the paths as ids
+    QVector<QVector<int>> tags;
+    QVector<int> matching;
+    for(const QString &path : paths) {
+        QVector<int> ids;
+        for(const QString &tag : path.split('/'))
+            if(!tag.isEmpty())
+                ids.push_back(m_names.intern(QStringView(tag)));
+
+        if(ids.size() && ids[0] == m_root->m_tag)
+            matching.push_back(tags.size());
+        tags.push_back(ids);
+    }
+
+    if(m_utf8_source.size())
+        m_size = filter_helper<XMLUtf8>(m_root, 0, tags, matching,
+                                        std::string_view(m_utf8_source.constData(),
+                                                         size_t(m_utf8_source.size())));
+    else
+        m_size = filter_helper<XMLUtf16>(m_root, 0, tags, matching, QStringView(m_utf16_source));
+
+    // every kept node is built
+    m_skip_index.clear();
+    m_skip_index.squeeze();
+}
+
+template<typename Encoding>
+int XMLTree::filter_helper(XMLNode *node, int depth,
+                           const QVector<QVector<int>> &paths,
+                           const QVector<int> &matching,
+                           typename Encoding::View source)
+{
+    // the node ends a path, build everything under it
+    for(const int path : matching) {
+        if(paths[path].size() == depth + 1) {
+            int size = 0;
+            QStack<XMLNode *> nodes;
+            nodes.push(node);
+            while(nodes.size()) {
+                XMLNode *top = nodes.pop();
+                ++size;
+                for(XMLNode *child = top->first_child(); child; child = child->m_next_sibling)
+                    nodes.push(child);
+            }
+            return size;
+        }
+    }
+
+    // the paths which go on to a child with the tag
+    QVector<int> next;
+    auto next_matching = [&](int tag) {
+        next.resize(0);
+        for(const int path : matching)
+            if(paths[path][depth + 1] == tag)
+                next.push_back(path);
+        return !next.isEmpty();
+    };
 
-    QStack<QString> stack;
+    int size = 1;
+    if(node->m_lazy >= 0) {
+        // build only the children on the paths
+        // the others are skipped with the elements under them
+        const int entry = node->m_lazy;
+        node->m_lazy = -1;
+        const int end = m_skip_index[entry].next;
+        for(int child = entry + 1; child < end; child = m_skip_index[child].next) {
+            if(!next_matching(m_names.intern(entry_tag<Encoding>(m_skip_index[child], source))))
+                continue;
+
+            XMLNode *created = create_node();
+            created->m_parent = node;
+            node->add_child(created);
+            load_entry<Encoding>(created, child, source);
+            size += filter_helper<Encoding>(created, depth + 1, paths, next, source);
+        }
+    } else {
+        // the top level elements are built already
+        // the children off the paths are unlinked
+        XMLNode *child = node->m_first_child;
+        node->m_first_child = nullptr;
+        node->m_last_child = nullptr;
+        node->m_children_size = 0;
+        while(child) {
+            XMLNode *sibling = child->m_next_sibling;
+            child->m_next_sibling = nullptr;
+            if(next_matching(child->m_tag)) {
+                node->add_child(child);
+                size += filter_helper<Encoding>(child, depth + 1, paths, next, source);
+            }
+            child = sibling;
+        }
+    }
+
+    return size;
+}
+
+XMLTree::NodeBuilder::NodeBuilder(XMLTree *tree)
+    : m_tree(tree), m_nodes()
+{
+
+}
+
+void XMLTree::NodeBuilder::start_node(int tag)
+{
+    XMLNode *parent = m_nodes.size() ? m_nodes.top() : nullptr;
+    if(!parent && !m_tree->m_root->is_leaf())
+        parent = m_tree->m_root;
+
+    XMLNode *node = m_tree->m_root;
+    if(parent) {
+        node = m_tree->create_node();
+        node->m_parent = parent;
+        parent->add_child(node);
+    }
+    node->m_tag = tag;
+    m_nodes.push(node);
+}
+
+void XMLTree::NodeBuilder::add_attribute(const XMLAttribute &attribute)
+{
+    m_nodes.top()->set_attribute(attribute);
+}
+
+void XMLTree::NodeBuilder::self_close()
+{
+    m_nodes.pop()->m_selfclosing = true;
+    ++m_tree->m_size;
+}
+
+XMLNode *XMLTree::NodeBuilder::close_node()
+{
+    XMLNode *node = m_nodes.top();
+    node->m_selfclosing = false;
+    ++m_tree->m_size;
+    return node;
+}
+
+void XMLTree::NodeBuilder::end_tag()
+{
+    m_nodes.pop();
+}
+
+class XMLTree::TreeBuilder : public XMLTree::NodeBuilder
+{
+public:
+    template<typename Text>
+    TreeBuilder(XMLTree *tree, const Text &source)
+        : NodeBuilder(tree), m_source(source.constData()) {}
+
+    template<typename View>
+    void start_tag(View tag)
+    {
+        start_node(m_tree->m_names.intern(tag));
+    }
+
+    template<typename View>
+    void attribute(View key, View value)
+    {
+        add_attribute({m_tree->m_names.intern(key), m_tree->m_arena.copy(value)});
+    }
+
+    template<typename View>
+    void close(View raw)
+    {
+        // the value is kept as a span of the source
+        // until it's requested
+        XMLNode *node = close_node();
+        node->m_source_size = int(raw.size());
+        if(raw.size())
+            node->m_source_offset = int(raw.data() - static_cast<const typename View::value_type *>(m_source));
+    }
+
+private:
+    // the text the tokens are views of
+    const void *m_source;
+};
+
+XMLTree::ValueBuilder::ValueBuilder(XMLTree *tree)
+    : NodeBuilder(tree)
+{
+    m_tree->clear();
+    m_tree->m_root = m_tree->create_node();
+}
+
+void XMLTree::ValueBuilder::start_tag(QStringView tag)
+{
+    start_node(m_tree->m_names.intern(tag));
+}
+
+void XMLTree::ValueBuilder::attribute(QStringView key, QStringView value)
+{
+    add_attribute({m_tree->m_names.intern(key), m_tree->m_arena.copy(value)});
+}
+
+void XMLTree::ValueBuilder::close(QStringView value)
+{
+    close_node()->m_value = m_tree->m_arena.copy(value);
+}
+
+template<typename Encoding>
+void XMLTree::load_tokens(const XMLBasicTokenList<Encoding> &list, bool checked)
+{
+    clear();
+    m_root = create_node();
+    retain_source(list.source());
+
+    TreeBuilder builder(this, list.source());
+    QVector<SyntaxSummary<Encoding>> summaries(1);
+    parse_helper(list, 0, list.size(), &builder, summaries[0]);
+
+    if(checked) {
+        const QVector<QPair<int, QString>> errors = merge_summaries(summaries);
+        if(errors.size()) {
+            clear();
+            throw errors;
+        }
+    }
+}
+
+template<typename Encoding>
+QVector<QPair<int, QString>> XMLTree::check_tokens(const XMLBasicTokenList<Encoding> &list,
+                                                   bool capture_all)
+{
+    const int n = list.size();
+    const int threads = qMin(QThreadPool::globalInstance()->maxThreadCount(),
+                             n / min_check_slice);
+
+    // split the tokens before the "<" and "</" where the slices
+    // are expected to start between nodes
+    QVector<SyntaxSummary<Encoding>> summaries;
+    if(n >= parallel_check_threshold && threads >= 2) {
+        int begin = 0;
+        for(int k = 1; k < threads; ++k) {
+            int split = qMax(begin + 1, int(qint64(n) * k / threads));
+            while(split < n &&
+                  list.kind(split) != XMLToken::Open &&
+                  list.kind(split) != XMLToken::EndOpen)
+                ++split;
+            if(split == n)
+                break;
+
+            summaries.append(SyntaxSummary<Encoding>());
+            summaries.last().begin = begin;
+            summaries.last().end = split;
+            begin = split;
+        }
+        summaries.append(SyntaxSummary<Encoding>());
+        summaries.last().begin = begin;
+        summaries.last().end = n;
+
+        QtConcurrent::blockingMap(summaries, [&list](SyntaxSummary<Encoding> &summary) {
+            parse_helper(list, summary.begin, summary.end,
+                         static_cast<TreeBuilder *>(nullptr), summary);
+        });
+
+        // a slice which ends inside a tag means the next one
+        // doesn't start between nodes, check the tokens in one go
+        for(int i = 0; i + 1 < summaries.size(); ++i) {
+            if(!summaries[i].complete) {
+                summaries.clear();
+                break;
+            }
+        }
+    }
+
+    if(summaries.isEmpty()) {
+        summaries.resize(1);
+        parse_helper(list, 0, n, static_cast<TreeBuilder *>(nullptr), summaries[0]);
+    }
+
+    const QVector<QPair<int, QString>> errors = merge_summaries(summaries);
+    if(!capture_all && errors.size())
+        throw errors.first();
+
+    return errors;
+}
+
+template<typename Encoding>
+QVector<QPair<int, QString>> XMLTree::merge_summaries(const QVector<SyntaxSummary<Encoding>> &summaries)
+{
+    QStack<typename Encoding::View> stack;
     QVector<QPair<int, QString>> errors;
+    int index = 0;
+
+    for(const SyntaxSummary<Encoding> &summary : summaries) {
+        for(const auto &entry : summary.entries) {
+            if(!entry.error.isEmpty()) {
+                errors.push_back({index + entry.index, entry.error});
+                continue;
+            }
+
+            // closing tag of a node opened before the slice
+            if(stack.size() && stack.top() == entry.tag)
+                stack.pop();
+            else
+                errors.push_back({index + entry.index,
+                                  stack.size() ? "Mismatched tages: Expected " + Encoding::decode(stack.top())
+                                               : "Closing tag without matched opening tag"});
+        }
+
+        for(const auto &tag : summary.open)
+            stack.push(tag);
+
+        index += summary.lines;
+    }
+
+    if(stack.size()) {
+        QString tags;
+        tags.reserve(stack.size() * 10);
+
+        while(stack.size()) {
+            tags += " <" + Encoding::decode(stack.top()) + ">";
+            stack.pop();
+        }
+        errors.push_back({index, "Incomplete tags:" + tags});
+    }
+
+    return errors;
+}
+
+template<typename Encoding, typename Builder>
+void XMLTree::parse_helper(const XMLBasicTokenList<Encoding> &list,
+                           int begin, int end,
+                           Builder *builder,
+                           SyntaxSummary<Encoding> &summary)
+{
+    // the tags opened in the slice
+    QStack<typename Encoding::View> &stack = summary.open;
+
+    QVector<typename Encoding::View> attributes;
 
     int index = 0;
-    int pos = 0;
+    int pos = begin;
 
-    auto throw_error = [&index, &errors, capture_all](const QString& error) {
-        if(capture_all)
-            errors.push_back({index, error});
-        else
-            throw qMakePair(index, error);
+    auto throw_error = [&index, &summary](const QString& error) {
+        summary.entries.push_back({index, error, typename Encoding::View()});
+    };
+
+    // the tokens past the slice are out of reach
+    auto kind = [&list, end](int i) {
+        return i < end ? list.kind(i) : XMLToken::End;
     };
 
-    auto ignore_white_spaces = [&list, &pos, &white_spaces, &index]() {
-        while(++pos < list.size() &&
-              white_spaces.exactMatch(list[pos]))
-            index += list[pos].count('\n');
+    auto ignore_white_spaces = [&list, &pos, &index, end]() {
+        while(++pos < end &&
+              list.kind(pos) == XMLToken::WhiteSpace)
+            index += list.lines(pos);
     };
 
-    while(pos < list.size()) {
+    while(pos < end) {
         // search for the start of the node
-        while(pos < list.size() &&
-              list[pos] != "<" &&
-              list[pos] != "</" /*&&
-              list[pos] != ">" &&
-              list[pos] != "/>"*/)
+        while(pos < end &&
+              kind(pos) != XMLToken::Open &&
+              kind(pos) != XMLToken::EndOpen)
         {
             ignore_white_spaces();
         }
 
-        if(pos == list.size())
+        if(pos == end)
             break;
 
-        if(list[pos] == ">" || list[pos] == "/>") {
-            throw_error("Didn'r expected " + list[pos]);
+        if(kind(pos) == XMLToken::Close || kind(pos) == XMLToken::SelfClose) {
+            throw_error("Didn'r expected " + Encoding::decode(list.text(pos)));
             ignore_white_spaces();
             continue;
 
         }
 
         // closing tag
-        if(list[pos] == "</") {
+        if(kind(pos) == XMLToken::EndOpen) {
             ignore_white_spaces();
 
-            if(pos == list.size()) {
+            if(pos == end) {
                 throw_error("Expected tag name");
+                summary.complete = false;
                 break;
             }
 
-            if(is_token(list[pos])) {
+            if(list[pos].is_markup()) {
                 throw_error("Expected tag name");
                 ignore_white_spaces();
                 continue;
             }
 
-            if(!(stack.size() && stack.top() ==  list[pos])) {
-                throw_error( stack.size() ? "Mismatched tages: Expected " + stack.top()
-                                          : "Closing tag without matched opening tag");
+            if(stack.isEmpty()) {
+                // it may close a node opened before the slice
+                summary.entries.push_back({index, QString(), list.text(pos)});
+            } else if(stack.top() != list.text(pos)) {
+                throw_error("Mismatched tages: Expected " + Encoding::decode(stack.top()));
             } else {
                 stack.pop();
+                if(builder)
+                    builder->end_tag();
             }
             continue;
         }
@@ -188,267 +944,135 @@ int XMLTree::syntax_check(QTextStream &input, bool capture_all)
         // opening tag
         ignore_white_spaces();
 
-        if(pos == list.size()) {
+        if(pos == end) {
             throw_error("Expected opening tag");
+            summary.complete = false;
             break;
         }
 
-        if(is_token(list[pos])) {
+        if(list[pos].is_markup()) {
             throw_error("Expected tag name");
             ignore_white_spaces();
             continue;
         }
 
-        stack.push(list[pos]);
+        stack.push(list.text(pos));
+
+        if(builder)
+            builder->start_tag(list.text(pos));
 
         ignore_white_spaces();
 
-        if(pos == list.size()) {
+        if(pos == end) {
             throw_error("Expected > or />");
+            summary.complete = false;
             break;
         }
 
         // attributes
-        HashMap<QString, int> attributes;
-        while(list[pos] != ">" && list[pos] != "/>") {
+        // a tag has a few of them, repeats are found by a linear search
+        attributes.resize(0);
+        while(kind(pos) != XMLToken::Close && kind(pos) != XMLToken::SelfClose) {
+
+            if(pos == end) {
+                throw_error("Expected > or />");
+                summary.complete = false;
+                break;
+            }
 
-            if(is_token(list[pos])) {
-                throw_error("Didn't expect \"" + list[pos] +"\"");
+            if(list[pos].is_markup()) {
+                throw_error("Didn't expect \"" + Encoding::decode(list.text(pos)) +"\"");
                 ignore_white_spaces();
                 continue;
             }
 
-            if(attributes.contains(list[pos]))
-                throw_error("Repeated attributes: \"" + list[pos] + "\"");
+            const typename Encoding::View attribute = list.text(pos);
+            if(std::find(attributes.cbegin(), attributes.cend(), attribute) != attributes.cend())
+                throw_error("Repeated attributes: \"" + Encoding::decode(attribute) + "\"");
             else
-                attributes[list[pos]];
+                attributes.push_back(attribute);
 
             ignore_white_spaces();
 
-            if(pos == list.size()) {
+            if(pos == end) {
                 throw_error("Expected > or />");
+                summary.complete = false;
                 break;
             }
 
-            if(list[pos] != "=")
+            if(kind(pos) != XMLToken::Equal)
                 throw_error("Expected =");
 
-            if(list[pos] == ">" || list[pos] == "/>")
+            if(kind(pos) == XMLToken::Close || kind(pos) == XMLToken::SelfClose)
                 break;
 
             ignore_white_spaces();
 
-            if(pos == list.size() || list[pos] == ">" || list[pos] == "/>") {
+            if(pos == end ||
+                    kind(pos) == XMLToken::Close ||
+                    kind(pos) == XMLToken::SelfClose) {
                 throw_error("Expected attribute value");
+                if(pos == end)
+                    summary.complete = false;
                 break;
             }
 
+            if(builder)
+                builder->attribute(attribute, list.text(pos));
+
             ignore_white_spaces();
 
-            if(pos == list.size()) {
+            if(pos == end) {
                 throw_error("Expected > or />");
+                summary.complete = false;
                 break;
             }
         }
 
         // selfclosing tag
-        if(list[pos] == "/>")
+        if(kind(pos) == XMLToken::SelfClose)
         {
-            if(stack.size())
+            if(stack.size()) {
                 stack.pop();
-            else
+                if(builder)
+                    builder->self_close();
+            } else {
                 throw_error("Didn't expect />");
-        }
-        ignore_white_spaces();
-
-
-    }
-
-    if(stack.size()) {
-        QString tags;
-        tags.reserve(stack.size() * 10);
-
-        while(stack.size()) {
-            tags += " <" + stack.top() + ">";
-            stack.pop();
-        }
-        throw_error("Incomplete tags:" + tags);
-    }
-
-    qDebug() << errors;
-    if(capture_all && errors.size())
-        throw  errors;
-
-    return errors.empty();
-
-
-}
-
-void XMLTree::load(QTextStream &input)
-{
-    QStringList list = tokenize(input);
-
-    if(m_root) {
-        delete m_root;
-        m_size = 0;
-    }
-    m_root = new XMLNode;
-    m_root->m_parent = nullptr;
-    load_helper(list, 0, m_root);
-
-}
-
-void XMLTree::load_helper(const QStringList& list,
-                          int pos,
-                          XMLNode* node)
-{
-    // regex to match white spaces
-    QRegExp white_spaces("[\\s]+");
-
-    // QStrings to hold the tag and value
-    QString tag, value;
-    // QStrings to hold attributes
-    QString att_name, att_value;
-
-    //    qDebug() << node << pos << m_size << node->m_parent ;
-    // node must be initalized before calling the function
-    if(node == nullptr)
-        return;
-    while(pos <= list.size()) {
-        //        qDebug() << node << pos << m_size << node->m_parent ;
-
-        // store node_parent
-        XMLNode * node_parent = node->m_parent;
-
-        // search for the start of the node
-        while(pos < list.size() &&
-              list[pos] != "<" &&
-              list[pos] != "</")
-            pos++;
-
-        // found "</"
-        // return to the parent of the current parent
-        if(pos < list.size() && list[pos] == "</" &&
-                node_parent && node_parent->m_parent)
-        {
-            XMLNode * sibling = new XMLNode;
-            if(!sibling)
-                throw "No memory left";
-            sibling->m_parent = node_parent->m_parent;
-            node_parent->m_parent->add_child(sibling);
-            pos++;
-            node = sibling;
-
-            // delete the last added node
-            delete node_parent->m_children.back();
-            node_parent->m_children.pop_back();
-
-            // continue exploraing other nodes
-            continue;
-        }
-
-        // if we found we are finished
-        // delete the last added node if it was a child
-        // the last added node has no use now
-        if(pos == list.size() ){
-            if(node_parent) {
-                delete node_parent->m_children.back();
-                node_parent->m_children.pop_back();
             }
-            break;
-        }
-
-        // not a new node
-        // continue exploaring other nodes
-        if(list[pos] == "</") {
-            pos++;
-            continue;
         }
 
-        // extract node tag
-        // ignore white spaces
-        while(white_spaces.exactMatch(list[++pos]));
-        tag = list[pos++];
-
-        //    qDebug() << tag;
-        node->m_tag = tag;
-
-        // ignore white spaces
-        while(white_spaces.exactMatch(list[pos])) ++pos;
-
-        // extract attributes
-        while(list[pos] != ">" && list[pos] != "/>") {
-
-            // extract attribute name
-            // ignore white spaces
-            while(white_spaces.exactMatch(list[pos])) ++pos;
-            att_name = list[pos];
-
-            // ignore white spaces
-            while(white_spaces.exactMatch(list[++pos]));
-
-
-            // attribute value should proceed an "="
-            // else throw an error
-            if(list[pos] == "=") {
-                while(white_spaces.exactMatch(list[++pos]));
-                att_value = list[pos++];
-            } else {
-                qDebug() << pos << list[pos];
-                throw QString("Expected = near index");
+        // normal node
+        // its value is the text up to the next tag
+        // including white spaces
+        if(kind(pos) == XMLToken::Close && builder) {
+            int last = pos + 1;
+            while(last < end &&
+                  kind(last) != XMLToken::Open &&
+                  kind(last) != XMLToken::EndOpen)
+                ++last;
+
+            // the raw text from the first token to the end of the last
+            // the builder reads the value from it with value_text
+            typename Encoding::View raw;
+            if(last > pos + 1) {
+                const typename Encoding::View first = list.text(pos + 1);
+                const typename Encoding::View back = list.text(last - 1);
+                raw = typename Encoding::View(first.data(), back.data() + back.size() - first.data());
             }
-
-            // add the current attribute and
-            // search for anthor
-            //        qDebug() << att_name << att_value;
-            node->add_attribute(att_name, att_value);
-
-            // ignore white spaces
-            while(white_spaces.exactMatch(list[pos])) ++pos;
+            builder->close(raw);
         }
+        ignore_white_spaces();
 
 
-
-        if(list[pos] == ">") {
-            // ignore the closing tag
-            ++pos;
-            // normal node
-            node->m_selfclosing = false;
-            // extract node value
-            // including white spaces
-            value = "";
-            while(list[pos] != "<" && list[pos] != "</")
-                value += list[pos++];
-            //    qDebug() << value;
-            node->m_value = value.trimmed();
-        } else {
-            // self closing node
-            node->m_selfclosing = true;
-        }
-
-        // increase number of nodes
-        ++m_size;
-
-        // Determine the next node
-        if(list[pos] == "<") {
-            // the next node is a child node
-            XMLNode * child = new XMLNode;
-            if(!child)
-                throw "No memory left";
-            child->m_parent = node;
-            node->add_child(child);
-            node = child;
-        }
-        else if (node->m_parent) {
-            // the next node is a sibling
-            // for the current node
-            XMLNode * sibling = new XMLNode;
-            if(!sibling)
-                throw "No memory left";
-            sibling->m_parent = node->m_parent;
-            node->m_parent->add_child(sibling);
-            pos++;
-            node = sibling;
-        }
     }
+
+    summary.lines = index;
 }
+
+// the flat documents are built by the same pass
+template void XMLTree::parse_helper(const XMLTokenList &, int, int,
+                                    XMLDocument::Builder *,
+                                    SyntaxSummary<XMLUtf16> &);
+template void XMLTree::parse_helper(const XMLUtf8TokenList &, int, int,
+                                    XMLDocument::Builder *,
+                                    SyntaxSummary<XMLUtf8> &);
@@ -1,8 +1,25 @@
 #ifndef XMLTREE_H
 #define XMLTREE_H
 
+#include <QPair>
+#include <QStack>
+#include <QStringList>
+#include <QVector>
+
+#include "lib/xmlarena.h"
 #include "lib/xmlnode.h"
+#include "lib/xmlscanner.h"
+#include "lib/xmlsymbols.h"
+
+class QFile;
+class QIODevice;
 
+/**
+ * @brief The XMLTree class
+ *        Owns the nodes of an XML document
+ *        they are allocated in its arena and
+ *        released together with the tree
+ */
 class XMLTree
 {
 public:
@@ -17,6 +34,17 @@ public:
       */
     ~XMLTree();
 
+    Q_DISABLE_COPY(XMLTree)
+
+    /**
+     * @brief The ValueBuilder class
+     *        builds the tree from the elements of another format
+     *        their values are copied to the tree rather than
+     *        kept as spans of a source, the elements after the root
+     *        are added as its children like the loader does
+     */
+    class ValueBuilder;
+
     /**
      * @brief dump
      * @return the XML Tree with the proper indentation
@@ -25,18 +53,132 @@ public:
      *         Minifying the XML removes all the unneeded
      *         spaces and newlines in the text including the
      *         values of the XML nodes
+     *         a level of indentation is the number of
+     *         fill characters, dump(1, '\t') indents with tabs
+     * @complexity O(sizeof(tree))
+     */
+    QString dump(int spaces = -1, QChar fill = ' ') const;
+
+    /**
+     * @brief dump_utf8
+     * @return the same as dump encoded in UTF-8
+     *         it's encoded while it's written
+     *         without building the UTF-16 text first
      * @complexity O(sizeof(tree))
      */
-    QString dump(int spaces = -1) const;
+    QByteArray dump_utf8(int spaces = -1, QChar fill = ' ') const;
+
+    /**
+     * @brief dump
+     *        write the same text as dump to the device in UTF-8
+     *        the stream flushes its buffer to the device as it fills
+     *        so the text is never held in memory as a whole
+     * @param device an open writable device like a QFile
+     * @complexity O(sizeof(tree))
+     */
+    void dump(QIODevice *device, int spaces = -1, QChar fill = ' ') const;
 
     /**
      * @brief load
      *        load the XML Tree from input stream
+     *        the text is kept by the tree and the values
+     *        of the nodes are read from it when requested
      *        The XML must be syntactically correct
      * @complexity O(length of(input))
      */
     void load(QTextStream& input);
 
+    /**
+     * @brief load
+     *        load the XML Tree from UTF-8 bytes
+     *        the bytes are tokenized in place and only
+     *        the tags and attributes are decoded
+     *        the bytes are kept by the tree as a shallow copy
+     *        raw data must outlive the tree
+     *        The XML must be syntactically correct
+     * @complexity O(length of(input))
+     */
+    void load(const QByteArray& input);
+
+    /**
+     * @brief load
+     *        load only the elements on the given paths
+     *        a path is the tags from the root separated by "/"
+     *        like "/users/user/posts", the elements at its end
+     *        are loaded with everything under them and their
+     *        ancestors without the children off the paths
+     *        the rest of the text is skipped by the scan
+     *        of load_lazy without building nodes
+     *        the root is always loaded and size is
+     *        the number of loaded nodes
+     *        The XML must be syntactically correct
+     * @complexity O(length of(input)) to scan it
+     *             O(size of(loaded nodes)) to build them
+     */
+    void load(QTextStream& input, const QStringList &paths);
+
+    /**
+     * @brief load
+     *        the same for UTF-8 bytes
+     *        raw data must outlive the tree
+     * @complexity O(length of(input))
+     */
+    void load(const QByteArray& input, const QStringList &paths);
+
+    /**
+     * @brief load_file
+     *        load the XML Tree from a UTF-8 file
+     *        it maps the file and parses its bytes in place
+     *        without decoding the whole text to UTF-16 first
+     *        the file stays mapped until the tree is cleared
+     *        The XML must be syntactically correct
+     *        it throws QString if the file can't be opened
+     * @param lazy load the file with load_lazy
+     * @complexity O(size of(file))
+     */
+    void load_file(const QString &path, bool lazy = false);
+
+    /**
+     * @brief load_lazy
+     *        load the XML Tree from input stream on demand
+     *        one scan of the text finds where every element ends
+     *        without building any node, then only the root is built
+     *        the children of a node are built the first time
+     *        they are requested and the elements under them
+     *        are skipped using the ends found by the scan
+     *        reading a lazy tree builds nodes, it isn't safe
+     *        to read it from more than one thread
+     *        The XML must be syntactically correct
+     * @complexity O(length of(input)) to scan it
+     *             O(size of(visited nodes)) to build them
+     */
+    void load_lazy(QTextStream& input);
+
+    /**
+     * @brief load_lazy
+     *        the same for UTF-8 bytes
+     *        raw data must outlive the tree
+     * @complexity O(length of(input))
+     */
+    void load_lazy(const QByteArray& input);
+
+    /**
+     * @brief load_checked
+     *        load the XML Tree from input stream
+     *        checking its syntax in the same pass
+     *        it throws QVector<MPair> of all encountered
+     *        errors like syntax_check and leaves the tree empty
+     * @complexity O(length of(input))
+     */
+    void load_checked(QTextStream& input);
+
+    /**
+     * @brief load_checked
+     *        the same for UTF-8 bytes
+     * @complexity O(length of(input))
+     */
+    void load_checked(const QByteArray& input);
+
     /**
      * @brief syntax_check
      *        checks if the XML is syntactically correct
@@ -53,6 +195,14 @@ public:
      */
     static int syntax_check(QTextStream& input, bool capture_all = true);
 
+    /**
+     * @brief syntax_check
+     *        the same for UTF-8 bytes
+     *        it reports the same errors and line numbers
+     * @complexity O(length of(input))
+     */
+    static int syntax_check(const QByteArray& input, bool capture_all = true);
+
     /**
      * @brief is_token
      *        static function checks if the given token
@@ -68,50 +218,353 @@ public:
      */
     int size() const { return m_size;}
 
+    /**
+     * @brief is_lazy
+     * @return true if the tree was loaded with load_lazy
+     *         its nodes may still be built when they're read
+     */
+    bool is_lazy() const { return !m_skip_index.isEmpty(); }
+
     XMLNode *root() const;
 
+    /**
+     * @brief memory_size
+     * @return number of bytes allocated for the nodes
+     *         their attributes and values
+     *         and the skip index of a lazy tree
+     */
+    size_t memory_size() const
+    {
+        return m_arena.size() + size_t(m_skip_index.capacity()) * sizeof(SkipEntry);
+    }
+
 private:
     /**
-     * @brief load_helper
-     *        load the xml tree to the given XML parent
-     *        it operates on single parent node
-     *        it can detect self-closing nodes
+     * @brief load_tokens
+     *        replace the tree with the one built from the tokens
+     * @param checked throw the syntax errors and leave the tree empty
+     */
+    template<typename Encoding>
+    void load_tokens(const XMLBasicTokenList<Encoding> &list, bool checked);
+
+    /**
+     * @brief The SyntaxSummary struct
+     *        the syntax of a slice of the tokens
+     *        the summaries of consecutive slices are merged
+     *        in order into the errors of the whole document
+     */
+    template<typename Encoding>
+    struct SyntaxSummary
+    {
+        struct Entry {
+            int index;
+            // empty for a closing tag which found no open tag
+            // in the slice, it's matched while merging
+            QString error;
+            typename Encoding::View tag;
+        };
+
+        int begin = 0;
+        int end = 0;
+        // the errors and the unmatched closing tags in order
+        // their index is relative to the start of the slice
+        QVector<Entry> entries;
+        // the tags left open at the end of the slice
+        QStack<typename Encoding::View> open;
+        // number of lines in the slice
+        int lines = 0;
+        // false if the slice ends inside a tag
+        bool complete = true;
+    };
+
+    /**
+     * @brief parse_helper
+     *        check the syntax of a slice of the tokens and
+     *        optionally build the xml tree in the same pass
      *        it ignores the meta data of xml as they are
      *        not part of the xml document
-     *        it operates on syntactically correct XML
-     *        with light error checking for the attribute list
      *
      *        it simply loop through the list of tokens
+     *        keeping a stack of the open tags
      *        if it encountered an opening tag
-     *        it will add this node as a child of the current node
-     *        else it will add it as a sibling for this node
-     *        if it encountered a second closing tag it will return to
-     *        the parent of the current node
+     *        it will add the node as a child of the top node
+     *        if it encountered a matched closing tag
+     *        it will pop the top node
      *
-     * @param list QStringList of tokens generated from tokenize function
-     * @param pos  starting postion in the list
-     * @param node the parent node
+     * @param list UTF-16 or UTF-8 list of tokens
+     * @param begin first token of the slice
+     *        it must be the first token or a "<" or "</"
+     * @param end past the last token of the slice
+     * @param builder receives the nodes in document order
+     *        or nullptr to only check the syntax
+     *        the slice must be the whole list to build a document
+     *        the builder is told about
+     *          start_tag(tag) an opening tag
+     *          attribute(key, value) an attribute of the last tag
+     *          self_close() the end of a self closing tag
+     *          close(raw) the end of an opening tag and
+     *                     the raw text of the value that follows
+     *          end_tag() a matched closing tag
+     * @param summary filled with the syntax of the slice
      */
-    void load_helper(const QStringList &list, int pos, XMLNode *node);
+    template<typename Encoding, typename Builder>
+    static void parse_helper(const XMLBasicTokenList<Encoding> &list,
+                             int begin, int end,
+                             Builder *builder,
+                             SyntaxSummary<Encoding> &summary);
+
+    /**
+     * @brief The NodeBuilder class
+     *        links the nodes the builders of the tree start
+     */
+    class NodeBuilder;
+
+    /**
+     * @brief The TreeBuilder class
+     *        builds the nodes of the tree for parse_helper
+     */
+    class TreeBuilder;
+
+    /**
+     * @brief check_tokens
+     *        check the syntax of large lists in slices
+     *        on the global thread pool
+     *        it falls back to a single pass if a slice
+     *        doesn't start between nodes
+     * @return the same errors as checking in a single pass
+     */
+    template<typename Encoding>
+    static QVector<QPair<int, QString>> check_tokens(const XMLBasicTokenList<Encoding> &list,
+                                                     bool capture_all);
+
+    /**
+     * @brief merge_summaries
+     *        match the closing tags of every slice with the tags
+     *        left open by the slices before it
+     * @return the errors of the slices in order
+     */
+    template<typename Encoding>
+    static QVector<QPair<int, QString>> merge_summaries(const QVector<SyntaxSummary<Encoding>> &summaries);
+
+    /**
+     * @brief The SkipEntry struct
+     *        an element of the source of a lazy tree
+     *        the entries are in document order so the elements
+     *        under an entry are the entries up to its next one
+     */
+    struct SkipEntry {
+        // offset of the "<" of its start tag
+        int begin;
+        // the entry after its last descendant
+        int next;
+    };
+
+    /**
+     * @brief load_lazy_source
+     *        build the skip index of the retained source
+     *        and the root from its first entry
+     */
+    template<typename Encoding>
+    void load_lazy_source(const typename Encoding::Text &source);
+
+    /**
+     * @brief load_entry
+     *        build the tag, attributes and value of the node
+     *        from the start tag of the entry
+     *        its children are left to expand
+     * @complexity O(length of(start tag) + length of(value))
+     */
+    template<typename Encoding>
+    void load_entry(XMLNode *node, int entry, typename Encoding::View source);
+
+    /**
+     * @brief expand
+     *        build the children of a lazy node
+     * @complexity O(number of children)
+     */
+    void expand(XMLNode *node);
+
+    template<typename Encoding>
+    void expand_helper(XMLNode *node, typename Encoding::View source);
+
+    /**
+     * @brief entry_tag
+     * @return the tag of the start tag of the entry
+     */
+    template<typename Encoding>
+    static typename Encoding::View entry_tag(const SkipEntry &entry,
+                                             typename Encoding::View source);
+
+    /**
+     * @brief filter_paths
+     *        keep only the nodes of a lazy tree on the paths
+     *        and build the nodes under the ends of the paths
+     */
+    void filter_paths(const QStringList &paths);
+
+    /**
+     * @brief filter_helper
+     *        keep the children of the node on the matching paths
+     * @param paths the ids of the tags of every path
+     * @param matching the paths which lead to the node
+     *        at the given depth
+     * @return number of nodes kept under the node and itself
+     */
+    template<typename Encoding>
+    int filter_helper(XMLNode *node, int depth,
+                      const QVector<QVector<int>> &paths,
+                      const QVector<int> &matching,
+                      typename Encoding::View source);
+
+    /**
+     * @brief dump_stream
+     *        dump the tree into output with the layout
+     *        of the number of spaces
+     * @param output one of the outputs of textoutput.h
+     */
+    template<typename Output>
+    void dump_stream(int spaces, QChar fill, Output &output) const;
 
     /**
      * @brief dump_helper
-     *        recursive funtion to dump XML tree into output
+     *        dump the XML tree under node into output
+     *        it walks the tree with a stack of the open nodes
+     *        so deep trees don't overflow the call stack
+     *        it's instantiated for every layout
+     *        so the loop doesn't check the layout
      * @param node   the current node
-     * @param spaces indentation size
+     * @param layout writes the indentation, the line ends
+     *               and the values
      * @param depth  current node depth
-     * @param output outputstream
+     * @param output the output of the text
      */
-    void dump_helper(XMLNode *node, int spaces, int depth, QTextStream &output) const;
+    template<typename Layout, typename Output>
+    void dump_helper(XMLNode *node, Layout &layout, int depth, Output &output) const;
 
     /**
      * @brief tokenize
-     * @return QStringList of XML tokens as well as white spaces
+     * @return XMLTokenList of XML tokens as well as white spaces
+     *         as spans of the text read from the input
      */
-    static QStringList tokenize(QTextStream& input);
+    static XMLTokenList tokenize(QTextStream& input);
 
+    /**
+     * @brief value_text
+     * @return the value of a node from its raw text in the source
+     *         the tokens of the text joined, decoded and trimmed
+     * @complexity O(length of(raw))
+     */
+    static QString value_text(QStringView raw);
+    static QString value_text(std::string_view raw);
+
+    /**
+     * @brief source_value
+     * @return the value of the raw text at the offset of the source
+     */
+    QString source_value(int offset, int size) const;
+
+    /**
+     * @brief retain_source
+     *        keep the text the tree is loaded from
+     *        the values of the nodes are offsets in it
+     */
+    void retain_source(const QString &source);
+    void retain_source(const QByteArray &source);
+
+    /**
+     * @brief create_node
+     * @return new node of this tree allocated in the arena
+     * @complexity amortized O(1)
+     */
+    XMLNode *create_node();
+
+    /**
+     * @brief clear
+     *        release all the nodes
+     * @complexity O(number of arena blocks)
+     */
+    void clear();
+
+    friend class XMLNode;
+    friend class XMLDocument;
+
+    XMLArena m_arena;
+    XMLSymbolTable m_names;
     XMLNode * m_root;
     int m_size;
+
+    // the source of the loaded tree
+    QString m_utf16_source;
+    QByteArray m_utf8_source;
+    // the mapped file of load_file
+    QFile * m_file;
+    // the elements of the source of a lazy tree
+    QVector<SkipEntry> m_skip_index;
+};
+
+class XMLTree::NodeBuilder
+{
+public:
+    /**
+     * @brief self_close
+     *        end the open element with a self closing tag
+     */
+    void self_close();
+
+    /**
+     * @brief end_tag
+     *        end the open element after its value
+     */
+    void end_tag();
+
+protected:
+    explicit NodeBuilder(XMLTree *tree);
+
+    /**
+     * @brief start_node
+     *        open an element with the interned tag
+     *        the elements after the root are added as its
+     *        children unless it has none, then they replace it
+     */
+    void start_node(int tag);
+
+    /**
+     * @brief add_attribute
+     *        add the attribute to the open element
+     */
+    void add_attribute(const XMLAttribute &attribute);
+
+    /**
+     * @brief close_node
+     *        close the start tag of the open element
+     * @return the element for its value to be set
+     */
+    XMLNode *close_node();
+
+    XMLTree *m_tree;
+    // the open elements
+    QStack<XMLNode *> m_nodes;
+};
+
+class XMLTree::ValueBuilder : public XMLTree::NodeBuilder
+{
+public:
+    /**
+     * @brief ValueBuilder
+     *        clear the tree to build it anew
+     */
+    explicit ValueBuilder(XMLTree *tree);
+
+    void start_tag(QStringView tag);
+
+    void attribute(QStringView key, QStringView value);
+
+    /**
+     * @brief close
+     *        close the start tag of the open element
+     *        with its value, end_tag ends the element
+     */
+    void close(QStringView value);
 };
 
 #endif // XMLTREE_H
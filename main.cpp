@@ -4,6 +4,7 @@
 #include "test/hashtest.cpp"
 #include "test/xmltest.cpp"
 #include "test/compresstest.cpp"
+#include "test/benchtest.cpp"
 
 int main(int argc, char *argv[])
 {
@@ -12,6 +13,7 @@ int main(int argc, char *argv[])
 //    hash_test_all();
 //    xml_test_all();
 //    compress_test_all();
+//    bench_test_all();
 
     MainWindow window;
     window.resize(640, 512);
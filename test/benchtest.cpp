@@ -0,0 +1,721 @@
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QRegExp>
+#include <QTextStream>
+#include <QThreadPool>
+
+#include "lib/cbor.h"
+#include "lib/json.h"
+#include "lib/jsonscanner.h"
+#include "lib/xmldocument.h"
+#include "lib/xmlformatter.h"
+#include "lib/xmlscanner.h"
+#include "lib/xmltree.h"
+
+/**
+ * @brief bench_scaled_sample
+ * @return data-sample.xml repeated under a single root
+ *         until it's at least the given number of MBs
+ */
+QString bench_scaled_sample(int megabytes)
+{
+    QFile file("../xml-editor/data/data-sample.xml");
+    file.open(QFile::ReadOnly);
+    QTextStream fs(&file);
+    const QString sample = fs.readAll();
+
+    const int copies = megabytes * 1024 * 1024 / (sample.size() * 2) + 1;
+
+    QString builder;
+    builder.reserve(sample.size() * copies + 32);
+    builder += "<bench>\n";
+    for(int i = 0; i < copies; i++)
+        builder += sample;
+    builder += "</bench>\n";
+
+    return builder;
+}
+
+/**
+ * @brief bench_mbps
+ * @return throughput in MB/s of UTF-16 text
+ */
+double bench_mbps(const QString &text, qint64 nsecs)
+{
+    return (text.size() * 2.0 / (1024 * 1024)) / (nsecs / 1e9);
+}
+
+/**
+ * @brief bench_mbps
+ * @return throughput in MB/s of UTF-8 text
+ */
+double bench_mbps(const QByteArray &text, qint64 nsecs)
+{
+    return (text.size() / (1024.0 * 1024)) / (nsecs / 1e9);
+}
+
+/**
+ * @brief The LargestWriteBuffer class
+ *        a buffer which keeps the size of its largest write
+ *        text held back by a writer reaches it in one write
+ */
+class LargestWriteBuffer : public QBuffer
+{
+public:
+    explicit LargestWriteBuffer(QByteArray *bytes) : QBuffer(bytes), m_largest(0) {}
+
+    qint64 largest_write() const { return m_largest; }
+
+protected:
+    qint64 writeData(const char *data, qint64 size) override
+    {
+        m_largest = qMax(m_largest, size);
+        return QBuffer::writeData(data, size);
+    }
+
+private:
+    qint64 m_largest;
+};
+
+/**
+ * @brief regex_tokenize
+ *        the QRegExp tokenizer XMLScanner replaced
+ *        kept as the reference of the token stream
+ */
+QStringList regex_tokenize(const QString &str)
+{
+    const QString word { "[\\w\\.\\$\\%\\^\\&\\#\\@\\*\\(\\-\\+\\-\\):']+" };
+    const QString literal_string { "\"[\\w\\s\\.\\$\\%\\^\\&\\#\\@\\*\\(\\-\\+\\-\\):/'`,;]+\"" };
+    const QString white_spaces { "[\\s]+" };
+    const QString xml_tokens { "<|>|</|=|/>|-->|<!--|<\\?|\\?>" };
+
+    const QRegExp xml_rx { "(" + xml_tokens + "|"
+                               + white_spaces + "|"
+                               + literal_string + "|"
+                               + word + ")" };
+    int pos = 0;
+    QStringList list;
+
+    while ((pos = xml_rx.indexIn(str, pos)) != -1) {
+        list << xml_rx.cap(1);
+        pos += xml_rx.matchedLength();
+    }
+
+    return list;
+}
+
+void bench_tokenize()
+{
+    const QString text = bench_scaled_sample(8);
+    QElapsedTimer timer;
+
+    timer.start();
+    QStringList regex_tokens = regex_tokenize(text);
+    qint64 regex_time = timer.nsecsElapsed();
+
+    timer.start();
+    QStringList scanner_tokens = XMLScanner::tokenize(text);
+    qint64 scanner_time = timer.nsecsElapsed();
+
+    timer.start();
+    XMLTokenList spans(text);
+    qint64 spans_time = timer.nsecsElapsed();
+
+    assert(regex_tokens == scanner_tokens);
+    assert(spans.size() == scanner_tokens.size());
+
+    qDebug() << "tokenize regex:  " << bench_mbps(text, regex_time) << "MB/s";
+    qDebug() << "tokenize scanner:" << bench_mbps(text, scanner_time) << "MB/s";
+    qDebug() << "tokenize spans:  " << bench_mbps(text, spans_time) << "MB/s";
+}
+
+void bench_utf8()
+{
+    QString text = bench_scaled_sample(8);
+    const QByteArray bytes = text.toUtf8();
+    QElapsedTimer timer;
+
+    timer.start();
+    XMLTokenList utf16_tokens(text);
+    qint64 utf16_tokenize = timer.nsecsElapsed();
+
+    timer.start();
+    XMLUtf8TokenList utf8_tokens(bytes);
+    qint64 utf8_tokenize = timer.nsecsElapsed();
+
+    assert(utf16_tokens.size() == utf8_tokens.size());
+
+    XMLTree utf16_tree;
+    QTextStream ts(&text, QIODevice::ReadOnly);
+    timer.start();
+    utf16_tree.load(ts);
+    qint64 utf16_load = timer.nsecsElapsed();
+
+    XMLTree utf8_tree;
+    timer.start();
+    utf8_tree.load(bytes);
+    qint64 utf8_load = timer.nsecsElapsed();
+
+    timer.start();
+    const QString utf16_dump = utf16_tree.dump(2);
+    qint64 utf16_dump_time = timer.nsecsElapsed();
+
+    timer.start();
+    const QByteArray utf8_dump = utf8_tree.dump_utf8(2);
+    qint64 utf8_dump_time = timer.nsecsElapsed();
+
+    assert(QString::fromUtf8(utf8_dump) == utf16_dump);
+
+    qDebug() << "input utf16:" << text.size() * 2 << "bytes utf8:" << bytes.size() << "bytes";
+    qDebug() << "tokenize utf16:" << bench_mbps(text, utf16_tokenize) << "MB/s"
+             << "utf8:" << bench_mbps(bytes, utf8_tokenize) << "MB/s";
+    qDebug() << "load utf16:" << utf16_load / 1e6 << "ms"
+             << "utf8:" << utf8_load / 1e6 << "ms";
+    qDebug() << "dump utf16:" << utf16_dump_time / 1e6 << "ms"
+             << "utf8:" << utf8_dump_time / 1e6 << "ms";
+}
+
+/**
+ * @brief bench_same_tokens
+ * @return true if both lists have the same tokens
+ */
+template<typename Encoding>
+bool bench_same_tokens(const XMLBasicTokenList<Encoding> &a, const XMLBasicTokenList<Encoding> &b)
+{
+    if(a.size() != b.size())
+        return false;
+
+    for(int i = 0; i < a.size(); ++i) {
+        if(a[i].kind != b[i].kind || a[i].offset != b[i].offset || a[i].length != b[i].length)
+            return false;
+    }
+    return true;
+}
+
+void bench_tokenize_parallel()
+{
+    const QString text = bench_scaled_sample(32);
+    const QByteArray bytes = text.toUtf8();
+    QElapsedTimer timer;
+
+    timer.start();
+    XMLTokenList utf16_single(text, 1);
+    qint64 utf16_single_time = timer.nsecsElapsed();
+
+    timer.start();
+    XMLTokenList utf16_parallel(text);
+    qint64 utf16_parallel_time = timer.nsecsElapsed();
+
+    timer.start();
+    XMLUtf8TokenList utf8_single(bytes, 1);
+    qint64 utf8_single_time = timer.nsecsElapsed();
+
+    timer.start();
+    XMLUtf8TokenList utf8_parallel(bytes);
+    qint64 utf8_parallel_time = timer.nsecsElapsed();
+
+    assert(bench_same_tokens(utf16_single, utf16_parallel));
+    assert(bench_same_tokens(utf8_single, utf8_parallel));
+
+    qDebug() << "threads:" << QThreadPool::globalInstance()->maxThreadCount();
+    qDebug() << "tokenize utf16 single:" << bench_mbps(text, utf16_single_time) << "MB/s"
+             << "parallel:" << bench_mbps(text, utf16_parallel_time) << "MB/s";
+    qDebug() << "tokenize utf8 single:" << bench_mbps(bytes, utf8_single_time) << "MB/s"
+             << "parallel:" << bench_mbps(bytes, utf8_parallel_time) << "MB/s";
+}
+
+void bench_syntax_check_parallel()
+{
+    QString text = bench_scaled_sample(32);
+    // an error at both ends so every slice has something to report
+    text.prepend("</stray>\n");
+    text.append("<open>\n");
+    QElapsedTimer timer;
+    QThreadPool *pool = QThreadPool::globalInstance();
+    const int threads = pool->maxThreadCount();
+
+    QVector<QPair<int, QString>> single_errors, parallel_errors;
+
+    pool->setMaxThreadCount(1);
+    QTextStream single(&text, QIODevice::ReadOnly);
+    timer.start();
+    try {
+        XMLTree::syntax_check(single);
+    } catch (const QVector<QPair<int, QString>> &errors) {
+        single_errors = errors;
+    }
+    qint64 single_time = timer.nsecsElapsed();
+
+    pool->setMaxThreadCount(threads);
+    QTextStream parallel(&text, QIODevice::ReadOnly);
+    timer.start();
+    try {
+        XMLTree::syntax_check(parallel);
+    } catch (const QVector<QPair<int, QString>> &errors) {
+        parallel_errors = errors;
+    }
+    qint64 parallel_time = timer.nsecsElapsed();
+
+    assert(single_errors.size() == 2);
+    assert(single_errors == parallel_errors);
+
+    qDebug() << "syntax check single:" << bench_mbps(text, single_time) << "MB/s"
+             << "parallel:" << bench_mbps(text, parallel_time) << "MB/s"
+             << "threads:" << threads;
+}
+
+void bench_tree_lifetime()
+{
+    QString text = bench_scaled_sample(32);
+    QTextStream in(&text, QIODevice::ReadOnly);
+    QElapsedTimer timer;
+
+    XMLTree *tree = new XMLTree;
+    timer.start();
+    tree->load(in);
+    qint64 load_time = timer.nsecsElapsed();
+    const int nodes = tree->size();
+
+    // the nodes are released with the arena blocks
+    // without visiting them one by one
+    timer.start();
+    delete tree;
+    qint64 destroy_time = timer.nsecsElapsed();
+
+    assert(nodes > 0);
+
+    qDebug() << "tree load:" << bench_mbps(text, load_time) << "MB/s"
+             << "destroy:" << destroy_time / 1000 << "us"
+             << "nodes:" << nodes;
+}
+
+void bench_document()
+{
+    QString text = bench_scaled_sample(32);
+    QElapsedTimer timer;
+
+    XMLTree tree;
+    QTextStream tree_input(&text, QIODevice::ReadOnly);
+    timer.start();
+    tree.load(tree_input);
+    qint64 tree_load = timer.nsecsElapsed();
+
+    XMLDocument document;
+    QTextStream document_input(&text, QIODevice::ReadOnly);
+    timer.start();
+    document.load(document_input);
+    qint64 document_load = timer.nsecsElapsed();
+
+    timer.start();
+    const QString tree_dump = tree.dump(2);
+    qint64 tree_dump_time = timer.nsecsElapsed();
+
+    timer.start();
+    const QString document_dump = document.dump(2);
+    qint64 document_dump_time = timer.nsecsElapsed();
+
+    timer.start();
+    const QString tree_json = JSON::xml2json(tree, 2);
+    qint64 tree_json_time = timer.nsecsElapsed();
+
+    timer.start();
+    const QString document_json = JSON::xml2json(document, 2);
+    qint64 document_json_time = timer.nsecsElapsed();
+
+    assert(tree.size() == document.size());
+    assert(tree_dump == document_dump);
+    assert(tree_json == document_json);
+
+    qDebug() << "load tree:" << bench_mbps(text, tree_load) << "MB/s"
+             << "document:" << bench_mbps(text, document_load) << "MB/s";
+    qDebug() << "dump tree:" << bench_mbps(text, tree_dump_time) << "MB/s"
+             << "document:" << bench_mbps(text, document_dump_time) << "MB/s";
+    qDebug() << "json tree:" << bench_mbps(text, tree_json_time) << "MB/s"
+             << "document:" << bench_mbps(text, document_json_time) << "MB/s";
+    qDebug() << "memory tree:" << tree.memory_size() / (1024 * 1024) << "MB"
+             << "document:" << document.memory_size() / (1024 * 1024) << "MB"
+             << "nodes:" << document.size();
+}
+
+void bench_lazy_load()
+{
+    const QByteArray bytes = bench_scaled_sample(32).toUtf8();
+    QElapsedTimer timer;
+
+    XMLTree tree;
+    timer.start();
+    tree.load(bytes);
+    qint64 load_time = timer.nsecsElapsed();
+
+    // open the document and follow its first branch
+    XMLTree lazy;
+    timer.start();
+    lazy.load_lazy(bytes);
+    qint64 lazy_time = timer.nsecsElapsed();
+    int depth = 0;
+    for(XMLNode *node = lazy.root(); node; node = node->first_child())
+        ++depth;
+    qint64 visit_time = timer.nsecsElapsed() - lazy_time;
+
+    assert(lazy.size() == tree.size());
+    assert(depth > 1);
+
+    qDebug() << "load:" << bench_mbps(bytes, load_time) << "MB/s"
+             << "lazy:" << bench_mbps(bytes, lazy_time) << "MB/s"
+             << "first branch:" << visit_time / 1000 << "us";
+    qDebug() << "memory load:" << tree.memory_size() / 1024 << "KB"
+             << "lazy:" << lazy.memory_size() / 1024 << "KB";
+}
+
+void bench_load_paths()
+{
+    const QByteArray bytes = bench_scaled_sample(32).toUtf8();
+    QElapsedTimer timer;
+
+    XMLTree tree;
+    timer.start();
+    tree.load(bytes);
+    qint64 load_time = timer.nsecsElapsed();
+
+    // keep only the words of the synsets
+    XMLTree words;
+    timer.start();
+    words.load(bytes, {"/bench/data/synsets/synset/word"});
+    qint64 paths_time = timer.nsecsElapsed();
+
+    assert(words.size() > 1);
+    assert(words.size() < tree.size());
+
+    qDebug() << "load:" << bench_mbps(bytes, load_time) << "MB/s"
+             << "paths:" << bench_mbps(bytes, paths_time) << "MB/s";
+    qDebug() << "nodes load:" << tree.size() << "paths:" << words.size();
+    qDebug() << "memory load:" << tree.memory_size() / 1024 << "KB"
+             << "paths:" << words.memory_size() / 1024 << "KB";
+}
+
+void bench_serialize()
+{
+    // a deep chain of elements and a flat root with many children
+    // the indentation of the chain grows with its depth
+    const int depth = 3000;
+    QString deep;
+    for(int i = 0; i < depth; ++i)
+        deep += "<node id=\"" + QString::number(i) + "\">";
+    for(int i = 0; i < depth; ++i)
+        deep += "</node>";
+
+    const int width = 500000;
+    QString wide = "<items>";
+    for(int i = 0; i < width; ++i)
+        wide += "<item id=\"" + QString::number(i) + "\">value</item>";
+    wide += "</items>";
+
+    for(const QString &text : {deep, wide, bench_scaled_sample(32)}) {
+        QString copy = text;
+        QTextStream in(&copy, QIODevice::ReadOnly);
+        XMLTree tree;
+        tree.load(in);
+
+        for(int spaces : {-1, 4}) {
+            QElapsedTimer timer;
+            timer.start();
+            const QString dump = tree.dump(spaces);
+            qint64 dump_time = timer.nsecsElapsed();
+
+            timer.start();
+            const QString json = JSON::xml2json(tree, spaces);
+            qint64 json_time = timer.nsecsElapsed();
+
+            qDebug() << "nodes:" << tree.size() << "spaces:" << spaces
+                     << "dump:" << bench_mbps(dump, dump_time) << "MB/s"
+                     << "json:" << bench_mbps(json, json_time) << "MB/s";
+        }
+    }
+}
+
+void bench_dump_device()
+{
+    const QByteArray bytes = bench_scaled_sample(32).toUtf8();
+    XMLTree tree;
+    tree.load(bytes);
+
+    QElapsedTimer timer;
+    QFile file("bench-dump.xml");
+
+    // build the whole text then write it
+    timer.start();
+    file.open(QFile::WriteOnly);
+    file.write(tree.dump_utf8(4));
+    file.close();
+    qint64 string_time = timer.nsecsElapsed();
+
+    // write it as it's serialized
+    timer.start();
+    file.open(QFile::WriteOnly);
+    tree.dump(&file, 4);
+    file.close();
+    qint64 device_time = timer.nsecsElapsed();
+
+    timer.start();
+    file.open(QFile::WriteOnly);
+    JSON::xml2json(tree, &file, 4);
+    file.close();
+    qint64 json_time = timer.nsecsElapsed();
+
+    file.remove();
+
+    qDebug() << "dump then write:" << bench_mbps(bytes, string_time) << "MB/s"
+             << "dump to file:" << bench_mbps(bytes, device_time) << "MB/s"
+             << "json to file:" << bench_mbps(bytes, json_time) << "MB/s";
+}
+
+void bench_formatter()
+{
+    QByteArray bytes = bench_scaled_sample(32).toUtf8();
+    QElapsedTimer timer;
+
+    // through a tree
+    timer.start();
+    XMLTree tree;
+    tree.load(bytes);
+    const QByteArray dump = tree.dump_utf8(4);
+    qint64 tree_time = timer.nsecsElapsed();
+
+    // straight from the events of the reader
+    QBuffer input(&bytes);
+    input.open(QIODevice::ReadOnly);
+    QByteArray output;
+    QBuffer buffer(&output);
+    buffer.open(QIODevice::WriteOnly);
+    timer.start();
+    XMLFormatter::format(&input, &buffer, 4);
+    qint64 format_time = timer.nsecsElapsed();
+
+    assert(output == dump);
+
+    qDebug() << "prettify tree:" << bench_mbps(bytes, tree_time) << "MB/s"
+             << "formatter:" << bench_mbps(bytes, format_time) << "MB/s";
+}
+
+void bench_stream_json()
+{
+    QByteArray bytes = bench_scaled_sample(32).toUtf8();
+    QElapsedTimer timer;
+
+    // through a tree
+    timer.start();
+    XMLTree tree;
+    tree.load(bytes);
+    const QString json = JSON::xml2json(tree, 4);
+    qint64 tree_time = timer.nsecsElapsed();
+
+    // straight from the events of the reader
+    QBuffer input(&bytes);
+    input.open(QIODevice::ReadOnly);
+    QByteArray output;
+    LargestWriteBuffer buffer(&output);
+    buffer.open(QIODevice::WriteOnly);
+    timer.start();
+    JSON::xml2json(&input, &buffer, 4);
+    qint64 stream_time = timer.nsecsElapsed();
+
+    // the text is written as it's converted, only the first node
+    // of a run is held back until it's known if the run is an array
+    assert(buffer.largest_write() < 1024 * 1024);
+
+    qDebug() << "xml2json tree:" << bench_mbps(bytes, tree_time) << "MB/s"
+             << "stream:" << bench_mbps(bytes, stream_time) << "MB/s"
+             << "same:" << (output == json.toUtf8())
+             << "largest write:" << buffer.largest_write() << "bytes";
+}
+
+void bench_json_grouping()
+{
+    // many small objects with children of a few tags
+    QByteArray bytes = "<bench>";
+    for(int i = 0; i < 200000; i++)
+        bytes += "<item id=\"1\"><a>1</a><b>2</b><a>3</a><c/><b>4</b></item>";
+    bytes += "</bench>";
+
+    XMLTree tree;
+    tree.load(bytes);
+    QElapsedTimer timer;
+
+    for(int spaces : {-1, 4}) {
+        timer.start();
+        const QString json = JSON::xml2json(tree, spaces);
+        qint64 json_time = timer.nsecsElapsed();
+
+        qDebug() << "xml2json spaces:" << spaces
+                 << json_time / tree.size() << "ns per node"
+                 << "size:" << json.size();
+    }
+}
+
+void bench_json_parallel()
+{
+    const QString text = bench_scaled_sample(32);
+    XMLTree tree;
+    tree.load(text.toUtf8());
+    QElapsedTimer timer;
+
+    timer.start();
+    const QString sequential = JSON::xml2json_parallel(tree, 4, 1, 1);
+    qint64 sequential_time = timer.nsecsElapsed();
+
+    timer.start();
+    const QString parallel = JSON::xml2json_parallel(tree, 4);
+    qint64 parallel_time = timer.nsecsElapsed();
+
+    assert(parallel == sequential);
+
+    qDebug() << "threads:" << QThreadPool::globalInstance()->maxThreadCount();
+    qDebug() << "xml2json sequential:" << bench_mbps(text, sequential_time) << "MB/s"
+             << "parallel:" << bench_mbps(text, parallel_time) << "MB/s";
+}
+
+void bench_json_round_trip()
+{
+    const QString text = bench_scaled_sample(32);
+    XMLTree tree;
+    tree.load(text.toUtf8());
+    QElapsedTimer timer;
+
+    timer.start();
+    const QString json = JSON::xml2json(tree, 2);
+    qint64 to_json_time = timer.nsecsElapsed();
+
+    // the structural characters alone
+    timer.start();
+    JSONStructuralIndex index(json);
+    qint64 index_time = timer.nsecsElapsed();
+
+    const QByteArray bytes = json.toUtf8();
+    XMLTree converted;
+    timer.start();
+    JSON::json2xml(bytes, converted);
+    qint64 to_xml_time = timer.nsecsElapsed();
+
+    assert(converted.size() == tree.size());
+    assert(JSON::xml2json(converted, 2) == json);
+
+    qDebug() << "json size:" << json.size() << "structural:" << index.size();
+    qDebug() << "xml2json:" << bench_mbps(json, to_json_time) << "MB/s"
+             << "index:" << bench_mbps(json, index_time) << "MB/s"
+             << "json2xml:" << bench_mbps(json, to_xml_time) << "MB/s"
+             << "round trip:" << bench_mbps(json, to_json_time + to_xml_time) << "MB/s";
+}
+
+void bench_cbor()
+{
+    const QString text = bench_scaled_sample(32);
+    XMLTree tree;
+    tree.load(text.toUtf8());
+    QElapsedTimer timer;
+
+    timer.start();
+    const QByteArray json = JSON::xml2json(tree).toUtf8();
+    qint64 to_json_time = timer.nsecsElapsed();
+
+    timer.start();
+    const QByteArray cbor = CBOR::xml2cbor(tree);
+    qint64 to_cbor_time = timer.nsecsElapsed();
+
+    XMLTree from_json;
+    timer.start();
+    JSON::json2xml(json, from_json);
+    qint64 from_json_time = timer.nsecsElapsed();
+
+    XMLTree from_cbor;
+    timer.start();
+    CBOR::cbor2xml(cbor, from_cbor);
+    qint64 from_cbor_time = timer.nsecsElapsed();
+
+    assert(from_cbor.size() == tree.size());
+    assert(CBOR::xml2cbor(from_cbor) == cbor);
+
+    qDebug() << "json size:" << json.size() << "cbor size:" << cbor.size();
+    qDebug() << "ns per node xml2json:" << to_json_time / tree.size()
+             << "xml2cbor:" << to_cbor_time / tree.size()
+             << "json2xml:" << from_json_time / tree.size()
+             << "cbor2xml:" << from_cbor_time / tree.size();
+}
+
+void bench_dump_layouts()
+{
+    const QByteArray bytes = bench_scaled_sample(32).toUtf8();
+    XMLTree tree;
+    tree.load(bytes);
+
+    QElapsedTimer timer;
+    timer.start();
+    const QString minified = tree.dump();
+    qint64 minified_time = timer.nsecsElapsed();
+
+    timer.start();
+    const QString spaces = tree.dump(4);
+    qint64 spaces_time = timer.nsecsElapsed();
+
+    timer.start();
+    const QString tabs = tree.dump(1, '\t');
+    qint64 tabs_time = timer.nsecsElapsed();
+
+    assert(tabs.size() < spaces.size());
+
+    qDebug() << "ns per node minified:" << minified_time / tree.size()
+             << "spaces:" << spaces_time / tree.size()
+             << "tabs:" << tabs_time / tree.size();
+}
+
+void bench_presized_dump()
+{
+    const QByteArray bytes = bench_scaled_sample(32).toUtf8();
+    XMLTree tree;
+    tree.load(bytes);
+    QElapsedTimer timer;
+
+    // the strings are sized first and allocated once
+    timer.start();
+    const QString dump = tree.dump(4);
+    qint64 dump_time = timer.nsecsElapsed();
+
+    timer.start();
+    const QString json = JSON::xml2json(tree, 4);
+    qint64 json_time = timer.nsecsElapsed();
+
+    // the same text through a stream
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    timer.start();
+    tree.dump(&buffer, 4);
+    qint64 stream_time = timer.nsecsElapsed();
+
+    qDebug() << "dump:" << dump_time / tree.size() << "ns per node"
+             << "streamed:" << stream_time / tree.size() << "ns per node"
+             << "json:" << json_time / tree.size() << "ns per node";
+    qDebug() << "dump size:" << dump.size() << "capacity:" << dump.capacity()
+             << "json size:" << json.size() << "capacity:" << json.capacity();
+}
+
+void bench_test_all()
+{
+//    bench_tokenize();
+//    bench_utf8();
+//    bench_tokenize_parallel();
+//    bench_syntax_check_parallel();
+//    bench_tree_lifetime();
+//    bench_document();
+//    bench_lazy_load();
+//    bench_load_paths();
+//    bench_serialize();
+//    bench_dump_device();
+//    bench_formatter();
+//    bench_dump_layouts();
+//    bench_presized_dump();
+//    bench_stream_json();
+//    bench_json_grouping();
+//    bench_json_parallel();
+//    bench_json_round_trip();
+//    bench_cbor();
+}
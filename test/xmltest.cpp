@@ -1,8 +1,16 @@
 #include "lib/xmltree.h"
+#include "lib/cbor.h"
 #include "lib/json.h"
+#include "lib/xmldocument.h"
+#include "lib/xmlformatter.h"
+#include "lib/xmlscanner.h"
+#include "lib/xmlreader.h"
 
+#include <QBuffer>
 #include <QFile>
 
+#include <algorithm>
+
 void test_xmltree()
 {
     XMLTree tree;
@@ -41,8 +49,541 @@ void test_xml_syntax_check()
     XMLTree::syntax_check(ts);
 }
 
+void test_xml_scanner()
+{
+    QStringList tokens = XMLScanner::tokenize("<?xml a=\"1\"?><!-- c --><a:b x=\"v w\" y=\"\" />"
+                                              "</a:b>--->!/\"x=y\"");
+    QStringList expected { "<?", "xml", " ", "a", "=", "\"1\"", "?>",
+                           "<!--", " ", "c", " ", "-->",
+                           "<", "a:b", " ", "x", "=", "\"v w\"", " ", "y", "=", " ", "/>",
+                           "</", "a:b", ">", "---", ">",
+                           "x", "=", "y" };
+    assert(tokens == expected);
+}
+
+void xml_reader_signature(const XMLNode *node, QStringList &signature)
+{
+    QStringList attributes;
+    for(const auto& attribute : node->attributes())
+        attributes << attribute.key + "=" + attribute.value;
+    std::sort(attributes.begin(), attributes.end());
+
+    signature << node->tag() + "|" + attributes.join(' ') + "|" + node->value();
+    for(const XMLNode *child : node->children())
+        xml_reader_signature(child, signature);
+}
+
+void test_xml_reader()
+{
+    XMLTree tree;
+    QFile file("../xml-editor/data/data-sample.xml");
+    file.open(QFile::ReadOnly);
+    QTextStream fs(&file);
+    tree.load(fs);
+
+    QStringList expected;
+    xml_reader_signature(tree.root(), expected);
+
+    // tiny chunks to split the tokens between the chunks
+    file.seek(0);
+    XMLReader reader(&file, 7);
+    QStringList signature;
+    QStringList attributes;
+    QString tag, value;
+
+    auto flush = [&]() {
+        if(tag.isEmpty())
+            return;
+        std::sort(attributes.begin(), attributes.end());
+        signature << tag + "|" + attributes.join(' ') + "|" + value;
+        tag.clear();
+        value.clear();
+        attributes.clear();
+    };
+
+    while(reader.next() != XMLReader::EndDocument) {
+        switch(reader.event()) {
+        case XMLReader::StartElement:
+            flush();
+            tag = reader.name();
+            break;
+        case XMLReader::Attribute:
+            attributes << reader.name() + "=" + reader.value();
+            break;
+        case XMLReader::Text:
+            value = reader.value();
+            break;
+        default:
+            flush();
+            break;
+        }
+    }
+
+    assert(reader.depth() == 0);
+    assert(signature == expected);
+}
+
+void test_xml_load_checked()
+{
+    QFile file("../xml-editor/data/data-sample.xml");
+    file.open(QFile::ReadOnly);
+    QTextStream fs(&file);
+    QString text = fs.readAll();
+
+    XMLTree loaded;
+    QTextStream ls(&text, QIODevice::ReadOnly);
+    loaded.load(ls);
+
+    XMLTree checked;
+    QTextStream cs(&text, QIODevice::ReadOnly);
+    checked.load_checked(cs);
+    assert(checked.size() == loaded.size());
+    assert(checked.dump(2) == loaded.dump(2));
+
+    // the same errors as syntax_check
+    QString broken = "<a x=\"1\">\n<b>\n</c>\n";
+    QTextStream bs(&broken, QIODevice::ReadOnly);
+    QVector<QPair<int, QString>> errors;
+    try {
+        checked.load_checked(bs);
+    } catch (const QVector<QPair<int, QString>> &ex) {
+        errors = ex;
+    }
+
+    QTextStream ss(&broken, QIODevice::ReadOnly);
+    try {
+        XMLTree::syntax_check(ss);
+        assert(false);
+    } catch (const QVector<QPair<int, QString>> &ex) {
+        assert(errors == ex);
+    }
+    assert(checked.root() == nullptr);
+}
+
+void test_xml_load_file()
+{
+    XMLTree loaded;
+    QFile file("../xml-editor/data/data-sample.xml");
+    file.open(QFile::ReadOnly);
+    QTextStream fs(&file);
+    loaded.load(fs);
+
+    XMLTree mapped;
+    mapped.load_file("../xml-editor/data/data-sample.xml");
+    assert(mapped.size() == loaded.size());
+    assert(mapped.dump(2) == loaded.dump(2));
+
+    // the same tokens from UTF-8 and UTF-16
+    const QByteArray bytes = "<a\xc3\xa9 x=\"\xe2\x80\x83v\">\xf0\x9f\x98\x80w\xcc\x81</a\xc3\xa9>";
+    const QByteArrayList utf8 = XMLUtf8Scanner::tokenize(bytes);
+    const QStringList utf16 = XMLScanner::tokenize(QString::fromUtf8(bytes));
+    assert(utf8.size() == utf16.size());
+    for(int i = 0; i < utf8.size(); ++i)
+        assert(QString::fromUtf8(utf8[i]) == utf16[i]);
+}
+
+void test_xml_symbol_table()
+{
+    XMLSymbolTable names;
+    assert(names.intern(QStringView()) == 0);
+
+    // enough names to grow the table
+    QVector<int> ids;
+    for(int i = 0; i < 1000; ++i)
+        ids.push_back(names.intern(QStringView(QString("tag%1").arg(i))));
+    for(int i = 0; i < 1000; ++i) {
+        const QString name = QString("tag%1").arg(i);
+        assert(names.find(QStringView(name)) == ids[i]);
+        assert(names.intern(std::string_view(name.toStdString())) == ids[i]);
+        assert(names.name(ids[i]) == name);
+    }
+    assert(names.size() == 1001);
+    assert(names.find(QStringView(QString("missing"))) == -1);
+
+    // UTF-8 names are decoded to the same ids
+    const QString unicode = QString::fromUtf8("\xc3\xa9l\xc3\xa9ment");
+    assert(names.intern(std::string_view("\xc3\xa9l\xc3\xa9ment")) == names.intern(QStringView(unicode)));
+
+    // equal tags of a tree share the same id
+    QString text = "<a><b/><c/><b/></a>";
+    QTextStream in(&text, QIODevice::ReadOnly);
+    XMLTree tree;
+    tree.load(in);
+    const QList<XMLNode *> children = tree.root()->children();
+    assert(children[0]->tag_id() == children[2]->tag_id());
+    assert(children[0]->tag_id() != children[1]->tag_id());
+    assert(children[2]->tag() == "b");
+}
+
+void test_xml_attributes()
+{
+    // more attributes than the node keeps inline
+    QString text = "<a z=\"1\" y=\"2\" x=\"3\" w=\"4\" v=\"5\"><b k=\"v\"/></a>";
+    QTextStream in(&text, QIODevice::ReadOnly);
+    XMLTree tree;
+    tree.load(in);
+
+    XMLNode *root = tree.root();
+    assert(root->attributes_size() == 5);
+    assert(root->attribute_key(0) == "z");
+    assert(root->attribute_value(4) == "\"5\"");
+
+    // an existing key keeps its place
+    root->add_attribute("x", "\"0\"");
+    root->add_attribute("u", "\"6\"");
+    const QList<MPair<QString, QString>> attributes = root->attributes();
+    assert(attributes.size() == 6);
+    assert(attributes[2].key == "x" && attributes[2].value == "\"0\"");
+    assert(attributes[5].key == "u");
+
+    // dumped in document order
+    assert(tree.dump() == "<a z=\"1\" y=\"2\" x=\"0\" w=\"4\" v=\"5\" u=\"6\"><b k=\"v\"/></a>");
+}
+
+void test_xml_lazy_values()
+{
+    // the values are read from the source of the tree
+    XMLTree tree;
+    {
+        const QByteArray bytes = "<a><b>  one\n  two </b><c>caf\xc3\xa9</c><d></d></a>";
+        tree.load(bytes);
+    }
+    const QList<XMLNode *> children = tree.root()->children();
+    assert(children[0]->value() == "one\n  two");
+    assert(children[1]->value() == QString::fromUtf8("caf\xc3\xa9"));
+    assert(children[2]->value() == "");
+
+    // a set value replaces the one in the source
+    children[0]->set_value("three");
+    assert(children[0]->value() == "three");
+    assert(tree.dump() == QString::fromUtf8("<a><b>three</b><c>caf\xc3\xa9</c><d></d></a>"));
+
+    QString text = "<a><b>  one\n  two </b></a>";
+    QTextStream in(&text, QIODevice::ReadOnly);
+    tree.load(in);
+    text.clear();
+    assert(tree.root()->children()[0]->value() == "one\n  two");
+}
+
+void test_xml_load_lazy()
+{
+    XMLTree loaded;
+    loaded.load_file("../xml-editor/data/data-sample.xml");
+
+    XMLTree lazy;
+    lazy.load_file("../xml-editor/data/data-sample.xml", true);
+    assert(lazy.size() == loaded.size());
+
+    // the children are built as they are visited
+    XMLNode *first = lazy.root()->first_child();
+    assert(first->tag() == loaded.root()->first_child()->tag());
+    assert(first->attributes_size() == loaded.root()->first_child()->attributes_size());
+    assert(first->attribute_value(0) == loaded.root()->first_child()->attribute_value(0));
+    assert(lazy.dump(2) == loaded.dump(2));
+
+    // the children added to a lazy node follow the ones in the source
+    QString text = "<a><b>1</b><c><d/></c></a>";
+    QTextStream in(&text, QIODevice::ReadOnly);
+    XMLTree tree;
+    tree.load_lazy(in);
+    assert(!tree.root()->is_leaf());
+    tree.root()->add_attribute("x", "\"0\"");
+    assert(tree.dump() == "<a x=\"0\"><b>1</b><c><d/></c></a>");
+}
+
+void test_xml_load_paths()
+{
+    QString text = "<users>"
+                   "<user id=\"1\"><name>a</name><posts><post>x</post></posts></user>"
+                   "<user id=\"2\"><name>b</name><posts><post>y</post><post>z</post></posts></user>"
+                   "<groups><group>g</group></groups>"
+                   "</users>";
+
+    // only the elements on the paths and their subtrees are built
+    QTextStream in(&text, QIODevice::ReadOnly);
+    XMLTree tree;
+    tree.load(in, {"/users/user/posts"});
+    assert(tree.size() == 8);
+    assert(tree.dump() == "<users><user id=\"1\"><posts><post>x</post></posts></user>"
+                          "<user id=\"2\"><posts><post>y</post><post>z</post></posts></user></users>");
+
+    // a root that isn't on any path keeps no children
+    XMLTree other;
+    other.load(text.toUtf8(), {"/groups"});
+    assert(other.size() == 1);
+    assert(other.dump() == "<users></users>");
+}
+
+void test_xml_deep_dump()
+{
+    // deeper than the call stack would allow one frame per level
+    const int depth = 200000;
+    QString text;
+    text.reserve(depth * 7);
+    for(int i = 0; i < depth; ++i)
+        text += "<a>";
+    for(int i = 0; i < depth; ++i)
+        text += "</a>";
+
+    QTextStream in(&text, QIODevice::ReadOnly);
+    XMLTree tree;
+    tree.load(in);
+    assert(tree.size() == depth);
+    assert(tree.dump() == text);
+    assert(tree.dump(0).size() == 9 * depth);
+
+    const QString json = JSON::xml2json(tree);
+    assert(json.startsWith("{a:{a:{a:"));
+    assert(json.size() == 5 * depth + 6);
+}
+
+void test_xml_dump_device()
+{
+    XMLTree tree;
+    tree.load_file("../xml-editor/data/data-sample.xml");
+
+    QByteArray dump;
+    QBuffer dump_buffer(&dump);
+    dump_buffer.open(QIODevice::WriteOnly);
+    tree.dump(&dump_buffer, 2);
+    assert(dump == tree.dump_utf8(2));
+
+    QByteArray json;
+    QBuffer json_buffer(&json);
+    json_buffer.open(QIODevice::WriteOnly);
+    JSON::xml2json(tree, &json_buffer, 2);
+    assert(json == JSON::xml2json(tree, 2).toUtf8());
+}
+
+void test_xml_formatter()
+{
+    XMLTree tree;
+    tree.load_file("../xml-editor/data/data-sample.xml");
+
+    QFile file("../xml-editor/data/data-sample.xml");
+    file.open(QFile::ReadOnly);
+
+    for(int spaces : {-1, 0, 2}) {
+        file.seek(0);
+        QByteArray output;
+        QBuffer buffer(&output);
+        buffer.open(QIODevice::WriteOnly);
+        XMLFormatter::format(&file, &buffer, spaces);
+        assert(output == tree.dump_utf8(spaces));
+    }
+}
+
+void test_xml_dump_tabs()
+{
+    QString text = "<a x=\"1\"><b>t\n u</b><c/></a>";
+    QTextStream in(&text, QIODevice::ReadOnly);
+    XMLTree tree;
+    tree.load(in);
+
+    assert(tree.dump(1, '\t') == "<a x=\"1\">\n\t<b>\n\t\tt\n\t\tu\n\t</b>\n\t<c/>\n</a>\n");
+    assert(tree.dump(2) == "<a x=\"1\">\n  <b>\n    t\n    u\n  </b>\n  <c/>\n</a>\n");
+    assert(tree.dump() == "<a x=\"1\"><b>t u</b><c/></a>");
+}
+
+void test_xml_stream_json()
+{
+    XMLTree tree;
+    tree.load_file("../xml-editor/data/data-sample.xml");
+
+    QFile file("../xml-editor/data/data-sample.xml");
+    file.open(QFile::ReadOnly);
+
+    for(int spaces : {-1, 0, 2}) {
+        file.seek(0);
+        QByteArray output;
+        QBuffer buffer(&output);
+        buffer.open(QIODevice::WriteOnly);
+        JSON::xml2json(&file, &buffer, spaces);
+        assert(QString::fromUtf8(output) == JSON::xml2json(tree, spaces));
+    }
+
+    // the siblings with a tag are an array when they're next to each other
+    QByteArray text = "<a><b>1</b><b>2</b><c/><d>3</d></a>";
+    QBuffer input(&text);
+    input.open(QIODevice::ReadOnly);
+    QByteArray output;
+    QBuffer buffer(&output);
+    buffer.open(QIODevice::WriteOnly);
+    JSON::xml2json(&input, &buffer);
+    assert(output == "{a:{b:[\"1\",\"2\",],c:\"null\",d:\"3\",},}");
+
+    // otherwise their group can't be written without the whole parent
+    QByteArray apart = "<a><b>1</b><b>2</b><c/><b>3</b></a>";
+    QBuffer apart_input(&apart);
+    apart_input.open(QIODevice::ReadOnly);
+    QString error;
+    try {
+        JSON::xml2json(&apart_input, &buffer);
+    } catch (const QString &ex) {
+        error = ex;
+    }
+    assert(error == "The siblings with the tag b aren't next to each other");
+}
+
+void test_json_child_order()
+{
+    // the groups follow the first occurrence of their tags
+    QByteArray text = "<a><c/><b>1</b><c>2</c><d x=\"y\"/></a>";
+    XMLTree tree;
+    tree.load(text);
+    assert(JSON::xml2json(tree) == "{a:{c:[\"null\",\"2\",],b:\"1\",d:{#x:\"y\",},},}");
+
+    XMLTree lazy;
+    lazy.load_lazy(text);
+    XMLDocument document;
+    document.load(text);
+    assert(JSON::xml2json(lazy, 2) == JSON::xml2json(tree, 2));
+    assert(JSON::xml2json(document, 2) == JSON::xml2json(tree, 2));
+}
+
+void test_json_parallel()
+{
+    QFile file("../xml-editor/data/data-sample.xml");
+    file.open(QFile::ReadOnly);
+    const QByteArray text = file.readAll();
+
+    XMLTree tree;
+    tree.load(text);
+    XMLDocument document;
+    document.load(text);
+
+    for(int spaces : {-1, 2}) {
+        const QString json = JSON::xml2json_parallel(tree, spaces, 1, 1);
+        for(int depth : {1, 2, 3}) {
+            assert(JSON::xml2json_parallel(tree, spaces, depth, 4) == json);
+            assert(JSON::xml2json_parallel(document, spaces, depth, 4) == json);
+        }
+    }
+}
+
+void test_json2xml()
+{
+    // the inverse of the conversion of the sample
+    XMLTree tree;
+    tree.load_file("../xml-editor/data/data-sample.xml");
+    for(int spaces : {-1, 2}) {
+        const QString json = JSON::xml2json(tree, spaces);
+        XMLTree converted;
+        JSON::json2xml(json.toUtf8(), converted);
+        assert(converted.size() == tree.size());
+        assert(JSON::xml2json(converted, spaces) == json);
+    }
+
+    // quoted keys, escapes, numbers and null
+    XMLTree users;
+    JSON::json2xml(QByteArray("{\"users\": {\"#id\": \"1\", \"user\": [{\"name\": \"a\\\"b\"}, {\"age\": 5}], \"note\": null}}"), users);
+    assert(users.dump() == "<users id=\"1\"><user><name>a\"b</name></user><user><age>5</age></user><note/></users>");
+
+    QString error;
+    try {
+        JSON::json2xml(QByteArray("{\"a\": {\"b\": 1}"), users);
+    } catch (const QString &ex) {
+        error = ex;
+    }
+    assert(error == "Unexpected end at 14");
+}
+
+void test_xml2cbor()
+{
+    // the inverse of the conversion of the sample
+    XMLTree tree;
+    tree.load_file("../xml-editor/data/data-sample.xml");
+    const QByteArray cbor = CBOR::xml2cbor(tree);
+    XMLTree converted;
+    CBOR::cbor2xml(cbor, converted);
+    assert(converted.size() == tree.size());
+    assert(CBOR::xml2cbor(converted) == cbor);
+
+    // written to a device as it's encoded
+    QByteArray written;
+    QBuffer buffer(&written);
+    buffer.open(QIODevice::WriteOnly);
+    CBOR::xml2cbor(tree, &buffer);
+    assert(written == cbor);
+
+    // {"a": {"#id": "1", "b": ["x", null]}}
+    XMLTree small;
+    small.load(QByteArray("<a id=\"1\"><b>x</b><b/></a>"));
+    const QByteArray expected = QByteArray::fromHex("a16161a26323696461316162826178f6");
+    assert(CBOR::xml2cbor(small) == expected);
+    CBOR::cbor2xml(expected, converted);
+    assert(converted.dump() == "<a id=\"1\"><b>x</b><b/></a>");
+
+    QString error;
+    try {
+        CBOR::cbor2xml(expected.left(15), converted);
+    } catch (const QString &ex) {
+        error = ex;
+    }
+    assert(error == "Unexpected end at 15");
+}
+
+void test_xml_document()
+{
+    QFile file("../xml-editor/data/data-sample.xml");
+    file.open(QFile::ReadOnly);
+    QTextStream fs(&file);
+    QString text = fs.readAll();
+
+    XMLTree tree;
+    QTextStream ts(&text, QIODevice::ReadOnly);
+    tree.load(ts);
+
+    XMLDocument document;
+    QTextStream ds(&text, QIODevice::ReadOnly);
+    document.load(ds);
+
+    assert(document.size() == tree.size());
+    assert(document.dump() == tree.dump());
+    assert(document.dump(4) == tree.dump(4));
+    assert(JSON::xml2json(document, 2) == JSON::xml2json(tree, 2));
+
+    // the handles walk the same nodes as the tree
+    QStringList tree_signature, document_signature;
+    xml_reader_signature(tree.root(), tree_signature);
+    QStack<XMLDocument::Node> nodes;
+    nodes.push(document.root());
+    while(nodes.size()) {
+        const XMLDocument::Node node = nodes.pop();
+        QStringList attributes;
+        for(const auto& attribute : node.attributes())
+            attributes << attribute.key + "=" + attribute.value;
+        std::sort(attributes.begin(), attributes.end());
+        document_signature << node.tag() + "|" + attributes.join(' ') + "|" + node.value();
+
+        const QList<XMLDocument::Node> children = node.children();
+        for(int i = children.size() - 1; i >= 0; --i)
+            nodes.push(children[i]);
+    }
+    assert(tree_signature == document_signature);
+}
+
 void xml_test_all()
 {
     test_xmltree();
 //    test_xml_syntax_check();
+//    test_xml_scanner();
+//    test_xml_reader();
+//    test_xml_load_checked();
+//    test_xml_load_file();
+//    test_xml_symbol_table();
+//    test_xml_attributes();
+//    test_xml_lazy_values();
+//    test_xml_load_lazy();
+//    test_xml_load_paths();
+//    test_xml_deep_dump();
+//    test_xml_dump_device();
+//    test_xml_formatter();
+//    test_xml_dump_tabs();
+//    test_xml_stream_json();
+//    test_json_child_order();
+//    test_json_parallel();
+//    test_json2xml();
+//    test_xml2cbor();
+//    test_xml_document();
 }
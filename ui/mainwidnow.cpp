@@ -99,6 +99,11 @@ void MainWindow::documentWasModified()
 }
 
 bool MainWindow::checkSyntax()
+{
+    return parseDocument(nullptr);
+}
+
+bool MainWindow::parseDocument(XMLTree *tree)
 {
     xmlEditor->clearErrors();
 
@@ -108,7 +113,10 @@ bool MainWindow::checkSyntax()
     QGuiApplication::setOverrideCursor(Qt::WaitCursor);
 #endif
     try {
-        XMLTree::syntax_check(in);
+        if (tree)
+            tree->load_checked(in);
+        else
+            XMLTree::syntax_check(in);
 
 #ifndef QT_NO_CURSOR
         QGuiApplication::restoreOverrideCursor();
@@ -140,17 +148,13 @@ bool MainWindow::checkSyntax()
 
 void MainWindow::minify()
 {
-    QString str = xmlEditor->toPlainText();
-    QTextStream in(&str, QIODevice::ReadOnly);
+    XMLTree tree;
 
-    if (checkSyntax()) {
+    if (parseDocument(&tree)) {
 #ifndef QT_NO_CURSOR
         QGuiApplication::setOverrideCursor(Qt::WaitCursor);
 #endif
         try {
-            XMLTree tree;
-            tree.load(in);
-
             switch(tabber->currentIndex()) {
             case 0:
                 xmlEditor->setPlainText(tree.dump());
@@ -177,17 +181,13 @@ void MainWindow::minify()
 
 void MainWindow::prettify()
 {
-    QString str = xmlEditor->toPlainText();
-    QTextStream in(&str, QIODevice::ReadOnly);
+    XMLTree tree;
 
-    if (checkSyntax()) {
+    if (parseDocument(&tree)) {
 #ifndef QT_NO_CURSOR
         QGuiApplication::setOverrideCursor(Qt::WaitCursor);
 #endif
         try {
-            XMLTree tree;
-            tree.load(in);
-
             switch(tabber->currentIndex()) {
             case 0:
                 xmlEditor->setPlainText(tree.dump(2));
@@ -214,16 +214,13 @@ void MainWindow::prettify()
 
 void MainWindow::convertToJson()
 {
-    QString str = xmlEditor->toPlainText();
-    QTextStream in(&str, QIODevice::ReadOnly);
+    XMLTree tree;
 
-    if (checkSyntax()) {
+    if (parseDocument(&tree)) {
 #ifndef QT_NO_CURSOR
         QGuiApplication::setOverrideCursor(Qt::WaitCursor);
 #endif
         try {
-            XMLTree tree;
-            tree.load(in);
             jsonEditor->setPlainText(JSON::xml2json(tree, 2));
             tabber->setCurrentIndex(1);
         } catch (const std::exception &ex) {
@@ -14,6 +14,8 @@ class QPlainTextEdit;
 class QSessionManager;
 QT_END_NAMESPACE
 
+class XMLTree;
+
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
@@ -42,6 +44,7 @@ private slots:
 #endif
 
 private:
+    bool parseDocument(XMLTree *tree);
     void setupEditor();
     void setupActions();
     void setupStatusBar();
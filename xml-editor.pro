@@ -1,4 +1,4 @@
-QT += core gui
+QT += core gui concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -12,10 +12,20 @@ requires(qtConfig(filedialog))
 
 SOURCES += \
     compress/huffman.cpp \
+    lib/cbor.cpp \
+    lib/cborwriter.cpp \
     lib/json.cpp \
+    lib/jsonscanner.cpp \
 #    lib/jsonnode.cpp \
+    lib/xmlarena.cpp \
+    lib/xmlformatter.cpp \
+    lib/xmldocument.cpp \
     lib/xmlnode.cpp \
+    lib/xmlreader.cpp \
+    lib/xmlscanner.cpp \
+    lib/xmlsymbols.cpp \
     lib/xmltree.cpp \
+    test/benchtest.cpp \
     test/compresstest.cpp \
     test/hashtest.cpp \
     test/xmltest.cpp \
@@ -28,12 +38,26 @@ SOURCES += \
 HEADERS += \
     compress/huffman.h \
     compress/hnode.h \
+    lib/cbor.h \
+    lib/cborwriter.h \
+    lib/childgroups.h \
+    lib/dumplayout.h \
     lib/hashcode.h \
     lib/hashmap.h \
+    lib/indenttable.h \
     lib/json.h \
+    lib/jsonscanner.h \
 #    lib/jsonnode.h \
     lib/mpair.h \
+    lib/nodevalue.h \
+    lib/textoutput.h \
+    lib/xmlarena.h \
+    lib/xmlformatter.h \
+    lib/xmldocument.h \
     lib/xmlnode.h \
+    lib/xmlreader.h \
+    lib/xmlscanner.h \
+    lib/xmlsymbols.h \
     lib/xmltree.h \
     ui/codeeditor.h \
     ui/json_highlighter.h \